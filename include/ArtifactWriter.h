@@ -0,0 +1,29 @@
+/*Here we define a background writer for output artifacts (JSON, Graphviz, LP). Jobs run in submission order on
+one thread; the queue is bounded so a slow disk throttles the producer instead of growing memory.*/
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class ArtifactWriter {
+public:
+    explicit ArtifactWriter(size_t capacity = 8);
+    ~ArtifactWriter();
+
+    // Blocks while the queue is full
+    void submit(std::function<void()> job);
+    // Blocks until every submitted job has finished; call before mutating anything a job reads
+    void wait();
+
+private:
+    void run();
+
+    std::mutex mutex;
+    std::condition_variable not_empty, not_full, idle;
+    std::deque<std::function<void()>> jobs;
+    size_t capacity;
+    bool busy, stopping;
+    std::thread worker;
+};
@@ -0,0 +1,32 @@
+/*Here we solve a batch of scenes against one wall-clock budget. The difficulty of every scene is estimated from the
+features of its model before anything is solved; core-seconds are then handed out in proportion to difficulty,
+hardest scenes first. A scene that stops at its gap early returns the rest of its slice to the pool, and a scene that
+hits its time limit while its gap is still shrinking is resumed with a further slice.*/
+#pragma once
+#include "Solver.h"
+#include <functional>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+class BatchScheduler {
+public:
+    // One worker solver per core; configure is applied to each once, before its first scene
+    BatchScheduler(const BatchParams& params, const std::function<void(Solver&)>& configure);
+
+    // Solves every scene (same schema as Solver::loadSceneText) within params.budget seconds and returns one result
+    // record per scene, in input order. Scenes still waiting when the budget runs out get params.min_slice each.
+    std::vector<nlohmann::json> run(const std::vector<std::string>& scenes);
+
+    // Relative solve cost of a scene's model, the weight of its share of the budget
+    static double difficulty(const ModelFeatures& features);
+
+    BatchParams params;
+
+private:
+    // Runs fn(worker, solver) on one thread per worker solver and waits for all of them
+    void forEachWorker(const std::function<void(size_t, Solver&)>& fn);
+
+    std::vector<std::unique_ptr<Solver>> solvers;
+};
@@ -3,6 +3,7 @@
 #include <boost/graph/strong_components.hpp>
 #include "SceneGraph.h"
 #include "InputScene.h"
+#include "IncrementalCycleDetector.h"
 #include <map>
 #include <random>
 
@@ -25,6 +26,19 @@ public:
 
     SceneGraph process(const SceneGraph& inputGraph, const Boundary& boundary);
     void reset();
+    // Incremental mode: normalize a single streamed edge and check it against the dynamic topological
+    // orders. A cycle is reported through conflict_info/plan_info and the edge is not added.
+    bool insertEdge(SceneGraph& g, VertexDescriptor source, VertexDescriptor target, EdgeProperties ep);
+    // Puts back the conflicts found by process() after a rejected edge has been reported; the next edit does too
+    void clearRejection();
+    void eraseEdge(SceneGraph& g, VertexDescriptor source, VertexDescriptor target, EdgeType type);
+    void insertVertex(SceneGraph& g, const VertexProperties& vp);
+    // Groups of objects that can be swapped without changing feasibility or objective: same label,
+    // size/position data and flags, and identical relations to the same other objects.
+    std::vector<std::vector<VertexDescriptor>> findInterchangeableClasses(const SceneGraph& g);
+    // Returns the indices of arcs to remove so that the weighted digraph (n vertices) becomes acyclic: minimum
+    // weight for small components, a heuristic beyond. No removed arc can be put back without closing a cycle.
+    std::vector<int> feedbackArcSet(int n, const std::vector<std::pair<int, int>>& arcs, const std::vector<int>& weights);
 
     std::vector<EdgeType> edgetypes;
     std::vector<std::string> edgenames;
@@ -32,9 +46,21 @@ public:
     std::vector<std::string> orientationnames;
     std::string conflict_info;
     std::vector<std::string> plan_info;
+    // Statistics of the last process() call: parallel duplicates merged, ordering edges implied by transitivity
+    int merged_edges, implied_edges;
 
 private:
-    void removeCycles(SceneGraph& g, EdgeType edge_type);
+    bool normalizeEdge(EdgeProperties& ep);
+    void removeCycles(SceneGraph& g);
+    void markImpliedEdges(SceneGraph& g, EdgeType edge_type);
+    std::vector<int> exactFeedbackArcSet(int n, const std::vector<std::pair<int, int>>& arcs, const std::vector<int>& weights);
+    std::vector<int> greedyFeedbackArcSet(int n, const std::vector<std::pair<int, int>>& arcs, const std::vector<int>& weights);
+    void minimizeFeedbackArcSet(int n, const std::vector<std::pair<int, int>>& arcs, std::vector<int>& fas);
     Orientation oppositeOrientation(Orientation o);
     EdgeType oppositeEdgeType(EdgeType e);
+
+    IncrementalCycleDetector cycleDetector;
+    bool edge_rejected;
+    std::string standing_conflict_info;
+    std::vector<std::string> standing_plan_info;
 };
\ No newline at end of file
@@ -0,0 +1,33 @@
+/*Here we hand the layout formulation to Gurobi. Handles are indices into the variables this backend created, which
+match the model's column indices as long as every variable of the attached model is added through it.*/
+#pragma once
+#include "ModelBackend.h"
+#include <gurobi_c++.h>
+#include <vector>
+
+class GurobiBackend : public ModelBackend {
+public:
+    // Starts over on an empty model; all handles of the previous one are forgotten
+    void attach(GRBModel& model);
+
+    int addVars(int count, const double* lb, const double* ub, const char* types, const std::string* names) override;
+    // Builds every row with one addTerms call and adds the buffer with a single addConstrs call
+    void addRows(const RowBuffer& rows) override;
+    // One addTerms call for the quadratic and one for the linear part
+    void setObjective(ObjectiveAssembler& objective) override;
+    bool optimize() override;
+    double value(int var) const override;
+    double objectiveValue() const override;
+    int numVars() const override { return static_cast<int>(vars.size()); }
+    int numRows() const override { return rows; }
+
+    // Forgets all handles, for a model that was emptied
+    void clear();
+
+    GRBModel* model = nullptr;
+    // Variables by handle
+    std::vector<GRBVar> vars;
+
+private:
+    int rows = 0;
+};
@@ -0,0 +1,35 @@
+/*Here we maintain a dynamic topological order (Pearce-Kelly) for each normalized ordering edge type,
+so that edges streamed in one at a time can be checked for cycles without re-processing the whole graph.*/
+#pragma once
+#include "SceneGraph.h"
+#include <vector>
+
+class IncrementalCycleDetector {
+public:
+    IncrementalCycleDetector();
+    ~IncrementalCycleDetector();
+
+    // Rebuild the orders from a normalized graph. Edges that would close a cycle are left out.
+    void reset(const SceneGraph& g);
+    void addVertex();
+    // Inserts source -> target for LeftOf/FrontOf/Above (other types are accepted without checks).
+    // If the edge closes a cycle it is rejected, and cycle receives the path target -> ... -> source.
+    bool insertEdge(VertexDescriptor source, VertexDescriptor target, EdgeType type, std::vector<VertexDescriptor>& cycle);
+    void removeEdge(VertexDescriptor source, VertexDescriptor target, EdgeType type);
+
+private:
+    struct TypeOrder {
+        std::vector<int> ord, vertex_at;
+        std::vector<std::vector<int>> out_edges, in_edges;
+    };
+    int typeIndex(EdgeType type) const;
+    bool forwardSearch(TypeOrder& t, int v, int upper, int x);
+    void backwardSearch(TypeOrder& t, int v, int lower);
+    void reorder(TypeOrder& t);
+
+    std::vector<TypeOrder> orders;
+    std::vector<int> forward_visited, backward_visited;
+    std::vector<bool> visited;
+    // DFS tree of the last forward search; only entries of forward_visited (and the cycle's end) are valid
+    std::vector<int> parent;
+};
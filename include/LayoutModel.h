@@ -0,0 +1,51 @@
+/*Here we formulate the layout MILP of a processed scene graph: continuous position/size variables per object, the
+relation, wall, corner and non-overlap constraints, and the unweighted objective components. The model is written to
+a ModelBackend through variable handles, so building it needs no solver and can be timed or recorded on its own.*/
+#pragma once
+#include "GraphProcessor.h"
+#include "InputScene.h"
+#include "ModelBackend.h"
+#include "ObjectiveAssembler.h"
+#include "SceneGraph.h"
+#include "SolverProfiles.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+class LayoutModel {
+public:
+    LayoutModel(const SceneGraph& g, const Boundary& boundary);
+
+    // Finds the pairs that need non-overlap constraints on threads threads (0 uses every hardware thread) and
+    // decides per pair whether the U/D branches can ever be active. Sets vertical_decoupled when none can, so
+    // z/h can be solved as an independent continuous model.
+    void analyze(int threads);
+    // Adds variables, constraints and objective components. z/h and the rows that only involve them go to
+    // vertical, which is model itself unless vertical_decoupled. With break_symmetry, members of each class of
+    // interchangeable objects are ordered by x.
+    void build(ModelBackend& model, ModelBackend& vertical, GraphProcessor& processor, bool break_symmetry);
+
+    bool vertical_decoupled;
+    std::vector<std::pair<VertexDescriptor, VertexDescriptor>> overlap_pairs;
+    std::vector<bool> vertical_branch;
+    // Handles by object id; z/h are handles of the vertical backend
+    std::vector<int> x, y, z, l, w, h;
+    // Non-overlap and corner binaries, which tell layouts apart
+    std::vector<int> layout_binaries;
+    // Names of the symmetry breaking rows, and the sigma_R binaries they fix to 0 for same-class pairs
+    std::vector<std::string> symmetry_rows;
+    std::vector<int> symmetry_fixed_vars;
+    // Unweighted area, size, position and adjacency terms for model, and the vertical size/position terms
+    std::vector<ObjectiveAssembler> objective_terms, vertical_objective_terms;
+    // Pair, CloseBy/corner binary and area term counters
+    ModelFeatures features;
+
+private:
+    bool hasPath(VertexDescriptor start, VertexDescriptor target) const;
+    bool dfsCheckPath(VertexDescriptor u, VertexDescriptor target, EdgeType required_type, std::vector<bool>& visited) const;
+    void buildObjective();
+
+    const SceneGraph& g;
+    const Boundary& boundary;
+    int threads = 0;
+};
@@ -0,0 +1,44 @@
+/*Here we define an independent check of a solved layout against the scene's hard constraints. Positions and sizes are
+copied into structure-of-arrays buffers so the per-object checks are flat loops, and all-pairs box overlap is found by
+sweep-and-prune along x instead of testing every pair.*/
+#pragma once
+#include "InputScene.h"
+#include "SceneGraph.h"
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+struct Violation {
+    // Name of the violated constraint as used in the model, e.g. Object_1_LeftOf_Object_2
+    std::string constraint;
+    // Amount by which it is violated, in scene units; infinite (null in JSON) for a corner the room does not have
+    double magnitude;
+};
+
+class LayoutVerifier {
+public:
+    // Violations up to tolerance are solver round-off and not reported
+    explicit LayoutVerifier(double tolerance = 1e-4);
+
+    // Checks pos/size of every vertex of g; vertices without a position are skipped. CloseBy edges and the
+    // objective are not checked, they impose no hard constraint.
+    std::vector<Violation> verify(const SceneGraph& g, const Boundary& boundary);
+    static nlohmann::json toJson(const std::vector<Violation>& violations);
+
+    double tolerance;
+
+private:
+    void load(const SceneGraph& g);
+    void checkObjects(const SceneGraph& g, const Boundary& boundary);
+    void checkRelations(const SceneGraph& g);
+    void checkWallsAndCorners(const SceneGraph& g, const Boundary& boundary);
+    void checkOverlap();
+    void report(const std::string& constraint, double magnitude);
+
+    // By vertex index; NaN marks a missing value, so comparisons against it never report
+    std::vector<double> x, y, z, l, w, h;
+    std::vector<double> target_x, target_y, target_z, pos_tol_x, pos_tol_y, pos_tol_z;
+    std::vector<double> target_l, target_w, target_h, size_tol_l, size_tol_w, size_tol_h;
+    std::vector<int> ids;
+    std::vector<Violation> violations;
+};
@@ -0,0 +1,31 @@
+/*Here we define the interface between the layout formulation and the MILP solver it is handed to. Variables are
+referred to by integer handles, consecutive from 0 in creation order, rows come as buffered triplets and the objective
+as merged coefficients, so neither the formulation nor a backend that only records the model needs Gurobi.*/
+#pragma once
+#include "ModelBuilder.h"
+#include "ObjectiveAssembler.h"
+#include <string>
+
+// Variable types and row senses use Gurobi's character codes
+constexpr char kContinuous = 'C', kBinary = 'B';
+constexpr char kLessEqual = '<', kGreaterEqual = '>', kEqual = '=';
+
+class ModelBackend {
+public:
+    virtual ~ModelBackend() = default;
+
+    // Adds count variables and returns the handle of the first
+    virtual int addVars(int count, const double* lb, const double* ub, const char* types, const std::string* names) = 0;
+    int addVar(double lb, double ub, char type, const std::string& name) { return addVars(1, &lb, &ub, &type, &name); }
+    virtual void addRows(const RowBuffer& rows) = 0;
+    // Replaces the objective, which is minimized
+    virtual void setObjective(ObjectiveAssembler& objective) = 0;
+
+    // Returns whether a solution is available afterwards
+    virtual bool optimize() = 0;
+    virtual double value(int var) const = 0;
+    virtual double objectiveValue() const = 0;
+
+    virtual int numVars() const = 0;
+    virtual int numRows() const = 0;
+};
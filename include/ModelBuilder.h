@@ -0,0 +1,39 @@
+/*Here we build constraint families in parallel. Solver models must not be modified from several threads, so workers
+write rows as plain (variable handle, coefficient) triplets into buffers they own, and one thread hands the buffers
+to the model backend afterwards. Work is split into contiguous chunks and buffers are added in chunk order, so the
+model is the same for any number of threads.*/
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct RowBuffer {
+    // Row k has the terms [starts[k], starts[k + 1]) of vars/coeffs; vars are variable handles of the backend
+    std::vector<int> vars;
+    std::vector<double> coeffs;
+    std::vector<size_t> starts = { 0 };
+    std::vector<char> senses;
+    std::vector<double> rhs;
+    std::vector<std::string> names;
+
+    void add(std::initializer_list<std::pair<int, double>> terms, char sense, double rhs, std::string name);
+    void add(const std::vector<std::pair<int, double>>& terms, char sense, double rhs, std::string name);
+    size_t size() const { return senses.size(); }
+};
+
+class ModelBuilder {
+public:
+    // jobs <= 0 uses every hardware thread
+    explicit ModelBuilder(int jobs);
+
+    // Splits [0, count) into contiguous chunks of at least min_chunk items, one per thread, and runs
+    // fn(chunk, begin, end) for each. Returns the number of chunks; chunk indices are 0..chunks-1 in item order.
+    size_t forEachChunk(size_t count, size_t min_chunk, const std::function<void(size_t, size_t, size_t)>& fn) const;
+    // How many chunks forEachChunk will use for count items
+    size_t chunks(size_t count, size_t min_chunk) const;
+
+    int jobs;
+};
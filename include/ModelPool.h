@@ -0,0 +1,27 @@
+/*Here we hand out empty Gurobi models of one environment, so every solve starts from a fresh model instead of one
+emptied variable by variable. Models that were never written to are kept as spares; the others are freed when
+released, on the caller's thread, since the models share the environment.*/
+#pragma once
+#include <gurobi_c++.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class ModelPool {
+public:
+    explicit ModelPool(GRBEnv& env, size_t spares = 2);
+
+    // An empty model with preset applied; a spare when one is left
+    std::unique_ptr<GRBModel> acquire();
+    // Takes a model back. Unused models (nothing was added since acquire) become spares up to the spare count,
+    // every other model is freed.
+    void release(std::unique_ptr<GRBModel> model, bool unused);
+
+    // Applied to every model handed out, e.g. the solver parameters of the next solve
+    std::function<void(GRBModel&)> preset;
+
+private:
+    GRBEnv& env;
+    size_t max_spares;
+    std::vector<std::unique_ptr<GRBModel>> spares;
+};
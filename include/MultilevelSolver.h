@@ -0,0 +1,40 @@
+/*Here we define coarse-to-fine solving for large scenes. Objects are clustered along their relations, a coarse scene
+with one box per cluster is solved for the cluster frames, every cluster is then laid out inside its fixed frame, and
+pairs of related clusters are finally re-solved together to polish the seams. Every level is an ordinary scene solved
+by a child Solver, so the coarse scene is itself solved coarse-to-fine when it is still large.*/
+#pragma once
+#include "Solver.h"
+#include "SolverParams.h"
+#include <functional>
+#include <vector>
+
+class MultilevelSolver {
+public:
+    // configure is applied to every child solver before it loads its scene
+    MultilevelSolver(const MultilevelParams& params, const std::function<void(Solver&)>& configure);
+
+    // Writes pos/size of every vertex of the processed graph g. Returns false, leaving g untouched, when clustering
+    // does not shrink the scene or some level has no solution; the caller then solves the flat model.
+    bool solve(SceneGraph& g, const Boundary& boundary);
+
+private:
+    struct Frame { double x0, y0, x1, y1; };
+    typedef std::vector<std::vector<double>> Coordinates;
+
+    std::vector<std::vector<VertexDescriptor>> cluster(const SceneGraph& g) const;
+    bool solveCoarse(const SceneGraph& g, const Boundary& boundary, const std::vector<std::vector<VertexDescriptor>>& clusters,
+        std::vector<Frame>& frames);
+    bool refine(const SceneGraph& g, const Boundary& boundary, const std::vector<VertexDescriptor>& members, const Frame& frame,
+        Coordinates& pos, Coordinates& size);
+    void polish(SceneGraph& g, const Boundary& boundary, const std::vector<std::vector<VertexDescriptor>>& clusters,
+        const std::vector<Frame>& frames);
+    // Free objects keep their properties inside the frame, fixed objects are pinned to their current pos/size
+    SceneGraph subScene(const SceneGraph& g, const Boundary& boundary, const std::vector<VertexDescriptor>& free,
+        const std::vector<VertexDescriptor>& fixed, const Frame& frame, bool relaxed) const;
+    Boundary frameBoundary(const Frame& frame, const Boundary& boundary) const;
+    // Solves scene with a fresh child solver; nested lets the child go coarse-to-fine again
+    bool solveScene(const SceneGraph& scene, const Boundary& boundary, bool nested, Coordinates& pos, Coordinates& size);
+
+    MultilevelParams params;
+    std::function<void(Solver&)> configure;
+};
@@ -0,0 +1,44 @@
+/*Here we assemble quadratic objectives as plain coefficients. Squares of affine forms are expanded arithmetically
+into (variable pair, coefficient) entries instead of multiplying expression temporaries, and duplicates are merged
+by sorting, so a backend receives each variable pair once. Variables are referred to by backend handles, so terms
+assembled separately can be combined.*/
+#pragma once
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+class ObjectiveAssembler {
+public:
+    typedef std::pair<int, double> Term;
+    struct QuadEntry {
+        int a, b;
+        double coeff;
+    };
+
+    void addConstant(double c);
+    void addLinear(int var, double coeff);
+    // Adds coeff * a * b; a == b gives a square
+    void addQuadratic(int a, int b, double coeff);
+    // Adds coeff * (sum of terms + constant)^2
+    void addSquare(std::initializer_list<Term> terms, double constant, double coeff);
+    // Adds weight * other
+    void add(const ObjectiveAssembler& other, double weight);
+    // Multiplies every coefficient, e.g. to normalize by the number of terms
+    void scale(double factor);
+    void clear();
+    // Merges duplicate entries; the accessors below do it as needed
+    void merge();
+    size_t size();
+
+    // Merged terms, quadratic ones with a <= b, both sorted by variable
+    const std::vector<QuadEntry>& quadraticTerms();
+    const std::vector<Term>& linearTerms();
+    double constantTerm() const { return constant; }
+
+private:
+    double constant = 0;
+    std::vector<QuadEntry> quadratic;
+    std::vector<Term> linear;
+    bool merged = true;
+};
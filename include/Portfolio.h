@@ -0,0 +1,31 @@
+/*Here we define the shared state of a parallel solver portfolio: several differently configured copies of the
+same model run on separate threads, exchange incumbents and stop once one of them proves the target gap.*/
+#pragma once
+#include <atomic>
+#include <gurobi_c++.h>
+#include <mutex>
+#include <vector>
+
+struct PortfolioShared {
+	std::mutex mutex;
+	double best_obj = GRB_INFINITY;
+	std::vector<double> best_x;
+	int best_member = -1;
+	double target_gap = 0.01;
+	std::atomic<bool> done{ false };
+};
+
+class PortfolioCallback : public GRBCallback {
+public:
+	PortfolioCallback(PortfolioShared& shared, GRBVar* vars, int num_vars, int member);
+
+protected:
+	void callback() override;
+
+private:
+	bool gapReached(double bound);
+
+	PortfolioShared& shared;
+	GRBVar* vars;
+	int num_vars, member;
+};
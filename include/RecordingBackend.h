@@ -0,0 +1,47 @@
+/*Here we record a model instead of solving it, so model construction can be timed, counted and compared on machines
+without a solver license. The recorded model can be written in LP format, and optimize() replays a stored solution
+when one was loaded.*/
+#pragma once
+#include "ModelBackend.h"
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class RecordingBackend : public ModelBackend {
+public:
+    int addVars(int count, const double* lb, const double* ub, const char* types, const std::string* names) override;
+    void addRows(const RowBuffer& rows) override;
+    void setObjective(ObjectiveAssembler& objective) override;
+    // Succeeds only with a loaded solution that covers every variable; the objective is evaluated from it
+    bool optimize() override;
+    double value(int var) const override;
+    double objectiveValue() const override { return objective_value; }
+    int numVars() const override { return static_cast<int>(types.size()); }
+    int numRows() const override { return static_cast<int>(rows.size()); }
+
+    int numBinaries() const;
+    int numEqualities() const;
+    size_t numNonzeros() const { return rows.vars.size(); }
+    size_t numObjectiveTerms() const { return quadratic.size() + linear.size(); }
+
+    // Reads "name value" lines as written to Gurobi .sol files; '#' starts a comment. Values are matched to the
+    // variables by name when optimize() runs, so the file may come from a solve of the same scene elsewhere.
+    bool loadSolution(const std::string& path, std::string& error);
+    // Unnamed variables and rows are written as C<handle> and R<index>, as Gurobi names them
+    void writeLP(std::ostream& out) const;
+
+private:
+    std::string varName(int var) const;
+
+    std::vector<double> lb, ub;
+    std::vector<char> types;
+    std::vector<std::string> names;
+    RowBuffer rows;
+    std::vector<ObjectiveAssembler::QuadEntry> quadratic;
+    std::vector<ObjectiveAssembler::Term> linear;
+    double constant = 0;
+    std::unordered_map<std::string, double> stored;
+    std::vector<double> solution;
+    double objective_value = 0;
+};
@@ -27,6 +27,8 @@ struct EdgeProperties {
 	// Notice that align_edge = {0, 1, 2, 3}, each number represents the alignment of bottom/right/up/left ,respectively.
 	int align_edge;
 	EdgeType type;
+	// Set by GraphProcessor for ordering edges implied by transitivity: only the objective term is kept.
+	bool implied = false;
 };
 
 typedef boost::adjacency_list<
@@ -0,0 +1,35 @@
+/*Here we define fast scene loading: a SAX reader that fills SceneGraph/Boundary straight from the JSON token stream
+without building a DOM, and a versioned binary scene format (.ldsg) that is memory-mapped and decoded with plain copies.*/
+#pragma once
+#include "InputScene.h"
+#include "SceneGraph.h"
+#include <cstdint>
+#include <string>
+
+// Binary layout, host byte order (little-endian on all supported platforms):
+//   header   "LDSG", u32 version, u32 num_vertices, u32 num_edges
+//   boundary vec origin_pos, vec size, u32 num_points, num_points x vec
+//   vertex   i32 id, boundary, corner, orientation, u8 on_floor, hanging, str label,
+//            vec target_pos, target_size, pos_tolerance, size_tolerance
+//   edge     i32 source, target, type, align_edge, f64 distance, vec xyoffset
+// where vec is u32 n followed by n f64 and str is u32 n followed by n bytes. Tolerances are stored after
+// defaults were applied, so loading does no further work.
+constexpr char kSceneBinaryMagic[4] = { 'L', 'D', 'S', 'G' };
+constexpr uint32_t kSceneBinaryVersion = 1;
+
+// Fills tolerances left empty in the input from the target size, as the JSON reader always did
+void applyVertexDefaults(VertexProperties& vp);
+// Resets the fields that do not apply to the edge type
+void applyEdgeDefaults(EdgeProperties& ep);
+
+// Derives wall orientations and the corner vertex lists from boundary.points
+void computeBoundaryGeometry(Boundary& boundary);
+
+// All readers append to an empty graph and boundary and leave the boundary geometry to the caller.
+// On failure they return false and describe the problem in error.
+bool readSceneJson(const char* begin, const char* end, SceneGraph& graph, Boundary& boundary, std::string& error);
+bool readSceneBinary(const std::string& path, SceneGraph& graph, Boundary& boundary, std::string& error);
+// Picks the reader from the file's first bytes; the text of a JSON scene is moved to json_text when given
+bool readSceneFile(const std::string& path, SceneGraph& graph, Boundary& boundary, std::string& error,
+    std::string* json_text = nullptr);
+bool writeSceneBinary(const std::string& path, const SceneGraph& graph, const Boundary& boundary, std::string& error);
@@ -0,0 +1,30 @@
+/*Here we define the streaming mode: newline-delimited scene JSON in, one result line per scene out, in input order.
+Scenes are solved on a fixed pool of worker solvers and only a bounded window of records is in flight at a time.*/
+#pragma once
+#include "Solver.h"
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class SceneStream {
+public:
+    // configure is applied to every worker solver once, before its first record
+    SceneStream(int jobs, const std::function<void(Solver&)>& configure);
+
+    // Solves every non-empty line of in and hands each result line to emit, in input order, from the calling
+    // thread. Returns the number of records.
+    size_t run(std::istream& in, const std::function<void(const std::string&)>& emit);
+
+    // Records read but not yet emitted; bounds memory independent of stream length
+    size_t window;
+
+    // Result record of a scene that could not be read or solved
+    static nlohmann::json errorRecord(const std::string& error);
+
+private:
+    std::string solveRecord(Solver& solver, const std::string& line, size_t index);
+
+    std::vector<std::unique_ptr<Solver>> solvers;
+};
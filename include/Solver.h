@@ -1,10 +1,19 @@
 #pragma once
 
+#include "ArtifactWriter.h"
 #include "GraphProcessor.h"
+#include "GurobiBackend.h"
+#include "LayoutModel.h"
+#include "LayoutVerifier.h"
+#include "ModelPool.h"
+#include "Portfolio.h"
+#include "SolverParams.h"
+#include "SolverProfiles.h"
 #include <boost/graph/graphviz.hpp>
 #include <fstream>
 #include <gurobi_c++.h>
 #include <nlohmann/json.hpp>
+#include <string_view>
 
 extern std::vector<std::string> show_edges;
 extern std::vector<std::string> show_orientations;
@@ -71,28 +80,129 @@ struct edge_writer {
         else if (ep.type != CloseBy && ep.distance >= 0) {
             out << "Distance: " << ep.distance << "\\n";
         }
-        out << "\", color=\"" << color << "\"]";
+        out << "\", color=\"" << color << "\"";
+        if (ep.implied) {
+            out << ", style=dashed";
+        }
+        out << "]";
     }
     const SceneGraph& g;
 };
 
+// One alternative layout from the solution pool, positions and sizes indexed by object id
+struct Layout {
+    double objective;
+    std::vector<std::vector<double>> pos, size;
+};
+
+// Outcome of the last optimization of the layout model, for schedulers that hand out time in slices
+struct SolveProgress {
+    // Stopped by the time limit with the search tree intact, so resume() can continue it
+    bool time_limited = false;
+    // Relative MIP gap of the incumbent; 0 for a continuous model, infinite without a solution
+    double gap = 0;
+};
+
+// Files written by saveGraph, each opt-in; the command line enables output.json by default
+struct ArtifactOptions {
+    bool output_json = false;
+    bool graph_in = false;
+    bool graph_out = false;
+    // model.lp, plus model_vertical.lp when the vertical model is decoupled
+    bool model_lp = false;
+    std::string output_path = "output.json";
+};
+
 class Solver {
 public:
     Solver();
     ~Solver();
 
+    // Solves the loaded scene in memory; artifacts are only written by saveGraph
     void solve();
+    // Continues the last solve for up to seconds more if it stopped at its time limit; returns false otherwise
+    bool resume(double seconds);
+    // Features of the loaded scene's model, counted on a recording backend without building a Gurobi model
+    ModelFeatures estimateFeatures();
+    // Builds the constraint system once and re-optimizes for every weight vector, writing all layouts to one file
+    void sweep(const std::vector<std::vector<double>>& weights, const std::string& outputpath);
+    // Queues the enabled artifacts on the background writer and returns; the next call that changes the
+    // scene or model waits for the writes to finish
     void saveGraph();
+    // Blocks until all queued artifacts are on disk
+    void flushArtifacts();
+    // Reads a JSON or binary (.ldsg) scene; see SceneReader.h
     void readSceneGraph(const std::string& path);
+    // In-memory API: load an already-parsed scene (same schema as the input file) or native structs
+    void loadScene(nlohmann::json scene);
+    void loadScene(const SceneGraph& graph, const Boundary& sceneBoundary);
+    // Same schema as loadScene(json), read with the SAX reader; returns false and sets error on malformed input
+    bool loadSceneText(std::string_view text, std::string& error);
+    // The input scene with positions/sizes (or conflict_info/plan_info) filled in, as written to output.json
+    nlohmann::json result() const;
     void reset();
+    // Incremental editing: streamed edits are checked for cycles right away instead of re-running process().
+    // Edges are given by vertex index; edges between unknown objects and rejected edges return false.
+    void addVertex(const VertexProperties& vp);
+    bool addEdge(int source, int target, const EdgeProperties& ep);
+    bool removeEdge(int source, int target, EdgeType type);
 
     std::vector<double> hyperparameters;
+    SolverParams params;
+    // With two or more entries, every entry solves a copy of the model on its own thread
+    std::vector<SolverParams> portfolio;
+    static std::vector<SolverParams> defaultPortfolio(int members);
+    // Alternative layouts: up to num_layouts pool solutions that differ in at least min_binary_difference
+    // sigma/corner binaries and move some object by at least min_position_distance
+    int num_layouts, min_binary_difference;
+    double min_position_distance;
+    std::vector<Layout> layouts;
+    // Adaptive configuration: when profiles are loaded, params are selected from the model features
+    SolverProfiles profiles;
+    // Appends features, chosen profile and outcome of every solve as one JSON line
+    std::string features_log;
+    ArtifactOptions artifacts;
+    // Every solved layout is re-checked against the scene's hard constraints; violations go to output.json
+    bool verify_layout;
+    std::vector<Violation> violations;
+    // Large scenes are solved coarse-to-fine when multilevel.threshold is set
+    MultilevelParams multilevel;
+    // Threads that generate the non-overlap pairs and their rows; 0 uses every hardware thread
+    int build_threads;
+    // Set by a scheduler before solve(); overrides the time limit and threads of params, profiles and portfolio
+    // members. Multilevel children keep their own time limits.
+    SolveBudget budget;
+    SolveProgress progress;
+    // Whether the last solve produced positions and sizes, and the processed graph that holds them
+    bool hasLayout() const;
+    const SceneGraph& solvedGraph() const;
 private:
-    bool has_path(const SceneGraph& g, VertexDescriptor start, VertexDescriptor target);
-    bool dfs_check_path(const SceneGraph& g, VertexDescriptor u, VertexDescriptor target, EdgeType required_type, std::vector<bool>& visited);
+    void processScene();
+    nlohmann::json sceneToJson() const;
+    // The input scene as a JSON document: the retained DOM or text, else serialized from inputGraph
+    nlohmann::json inputJson() const;
+    // The input document that edits are applied to; nullptr when the result is serialized from inputGraph
+    nlohmann::json* sceneDocument();
+    bool validEdgeEnds(int source, int target) const;
+    // Writes positions/sizes (or conflict_info/plan_info) into a copy of the input scene
+    void fillResult(nlohmann::json& j) const;
     void addConstraints();
+    void applyObjectiveWeights(const std::vector<double>& weights);
+    void extractFeatures();
+    void logFeatures(double runtime);
+    void applyParams(GRBModel& m, const SolverParams& p);
+    // Overrides the time limit and threads of p with the budget, shared among runs parallel runs
+    void applyBudget(SolverParams& p, int runs = 1) const;
     void optimizeModel();
-    void handleInfeasibleModel();
+    void readModelSolution();
+    void applySolution();
+    void recordProgress();
+    bool solveMultilevel();
+    void verifyLayout();
+    bool optimizePortfolio();
+    void collectLayouts();
+    void handleInfeasibleModel(GRBModel& grbModel);
+    // Swaps in empty models from the pool
     void clearModel();
 
     SceneGraph inputGraph, g;
@@ -100,7 +210,29 @@ private:
     GraphProcessor graphProcessor;
 
     GRBEnv env;
-    GRBModel model;
+    // params of the current solve, after the selected profile and the budget
+    SolverParams solve_params;
+    // Hands out the models of each solve with solve_params already applied
+    ModelPool pool;
+    std::unique_ptr<GRBModel> model;
+    std::unique_ptr<GRBModel> verticalModel;
+    // The formulation of g, written to model and, for z/h when the vertical axis decouples, to verticalModel
+    LayoutModel layoutModel;
+    GurobiBackend backend, verticalBackend;
+    bool vertical_decoupled;
+    // Values of all variables of model, by index, from the run that produced the reported layout
+    std::vector<double> solution;
+    double objective_value;
+    bool has_layout;
+    std::vector<std::string> symmetry_constrs;
+    std::vector<GRBVar> symmetry_fixed_vars;
+    std::vector<GRBVar> layout_binaries;
+    ModelFeatures features;
 
     std::string inputpath;
+    nlohmann::json scene_json;
+    // Text of a scene read as JSON without a DOM, parsed only when a result is written
+    std::string scene_text;
+    // Declared last so it is destroyed, and drained, before the graphs and models its jobs read
+    ArtifactWriter writer;
 };
\ No newline at end of file
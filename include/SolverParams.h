@@ -0,0 +1,52 @@
+/*Here we define the Gurobi parameter set used for one optimization run.*/
+#pragma once
+#include <string>
+
+struct SolverParams {
+	// Defaults reproduce the original hand-tuned settings for small rooms
+	double time_limit = 10;
+	double mip_gap = 0.01;
+	int mip_focus = 1;
+	int method = 2;
+	double bar_conv_tol = 1e-4;
+	int cuts = 2;
+	int presolve = 0;
+	int seed = 0;
+	int threads = 0;
+	// Formulation alternative: keep the symmetry breaking rows of interchangeable objects
+	bool break_symmetry = true;
+	std::string name = "default";
+};
+
+// Coarse-to-fine solving of large scenes, see MultilevelSolver.h
+struct MultilevelParams {
+	// Scenes with more objects than this are solved coarse-to-fine; 0 always solves the flat model
+	int threshold = 0;
+	// Objects per cluster, except where Above/AlignWith chains force more objects together
+	int max_cluster_size = 8;
+	// Clusters refined at the same time
+	int jobs = 1;
+	// Re-solve pairs of related clusters together after refinement
+	bool polish = true;
+	// Cluster frame area relative to the summed footprint of its objects
+	double slack = 1.5;
+};
+
+// Limits a scheduler sets for the next solve of a scene; they win over params and profiles
+struct SolveBudget {
+	// Negative leaves the time limit to params
+	double seconds = -1;
+	// 0 leaves the thread count to params
+	int threads = 0;
+};
+
+// Batches of scenes sharing one deadline, see BatchScheduler.h
+struct BatchParams {
+	// Wall-clock seconds for the whole batch and the cores its scenes share
+	double budget = 60;
+	int cores = 1;
+	// No scene is started or extended with less time than this
+	double min_slice = 1;
+	// A scene stopped by its time limit gets another slice only while the last one cut its gap by this fraction
+	double min_gap_reduction = 0.1;
+};
@@ -0,0 +1,48 @@
+/*Here we define the model-size features extracted after addConstraints and the profile table that maps them
+to solver parameters. The table is a JSON config file, so it can be retuned offline without recompiling.*/
+#pragma once
+#include "SolverParams.h"
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+struct ModelFeatures {
+	int vertices = 0;
+	int overlap_pairs = 0;
+	int closeby_binaries = 0;
+	int corner_binaries = 0;
+	int binaries = 0;
+	int constraints = 0;
+	int equality_constraints = 0;
+	double equality_ratio = 0;
+	// Bilinear l*w area terms, which make the objective nonconvex
+	int nonconvex_terms = 0;
+	bool vertical_decoupled = false;
+};
+
+struct SolverProfile {
+	std::string name;
+	// Upper limits on the features; a negative limit is unbounded
+	int max_vertices = -1, max_overlap_pairs = -1, max_binaries = -1, max_nonconvex_terms = -1;
+	double max_equality_ratio = -1;
+	// Only the parameters given here replace the caller's
+	nlohmann::json params = nlohmann::json::object();
+	// Time limit grows with the binary count: params.time_limit + time_limit_per_binary * binaries, capped
+	double time_limit_per_binary = 0, max_time_limit = -1;
+};
+
+class SolverProfiles {
+public:
+	bool load(const std::string& path);
+	bool empty() const;
+	// First profile whose limits all hold; nullptr if none does
+	const SolverProfile* select(const ModelFeatures& features) const;
+	// base with the profile's parameters and time limit rule applied
+	SolverParams paramsFor(const SolverProfile& profile, const ModelFeatures& features, SolverParams base) const;
+
+	static nlohmann::json toJson(const ModelFeatures& features);
+	static SolverParams paramsFromJson(const nlohmann::json& j, SolverParams base);
+
+private:
+	std::vector<SolverProfile> profiles;
+};
@@ -0,0 +1,24 @@
+/*Here we define a thin C ABI over the llmdsl_core library, for embedding the solver without temporary files.
+All strings are UTF-8 JSON in the same schema as the command line input and output.json.*/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct llmdsl_solver llmdsl_solver;
+
+// Returns NULL if the solver (and its Gurobi environment) cannot be created
+llmdsl_solver* llmdsl_create(void);
+void llmdsl_destroy(llmdsl_solver* solver);
+// Weights of area, size error, position error and adjacency error
+void llmdsl_set_weights(llmdsl_solver* solver, double area, double size, double position, double adjacency);
+// Solves a scene graph given as JSON text. Returns the result JSON (free with llmdsl_free), or NULL on error.
+char* llmdsl_solve_json(llmdsl_solver* solver, const char* scene_json);
+// Message of the last failed call, empty if none; owned by the solver
+const char* llmdsl_last_error(const llmdsl_solver* solver);
+void llmdsl_free(char* str);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+#include "ArtifactWriter.h"
+#include <iostream>
+
+ArtifactWriter::ArtifactWriter(size_t capacity) : capacity(capacity), busy(false), stopping(false) {
+    worker = std::thread(&ArtifactWriter::run, this);
+}
+
+ArtifactWriter::~ArtifactWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    not_empty.notify_all();
+    worker.join();
+}
+
+void ArtifactWriter::submit(std::function<void()> job) {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_full.wait(lock, [this] { return jobs.size() < capacity; });
+    jobs.push_back(std::move(job));
+    not_empty.notify_one();
+}
+
+void ArtifactWriter::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return jobs.empty() && !busy; });
+}
+
+void ArtifactWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        not_empty.wait(lock, [this] { return stopping || !jobs.empty(); });
+        // Pending jobs are still written on shutdown
+        if (jobs.empty())
+            return;
+        std::function<void()> job = std::move(jobs.front());
+        jobs.pop_front();
+        busy = true;
+        not_full.notify_one();
+        lock.unlock();
+        try {
+            job();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Exception occurred while writing artifact: " << e.what() << std::endl;
+        }
+        catch (...) {
+            std::cerr << "Exception occurred while writing artifact" << std::endl;
+        }
+        lock.lock();
+        busy = false;
+        if (jobs.empty())
+            idle.notify_all();
+    }
+}
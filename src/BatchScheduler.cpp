@@ -0,0 +1,164 @@
+#include "BatchScheduler.h"
+#include "SceneStream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+BatchScheduler::BatchScheduler(const BatchParams& params, const std::function<void(Solver&)>& configure)
+    : params(params)
+{
+    this->params.cores = std::max(1, params.cores);
+    for (int k = 0; k < this->params.cores; ++k) {
+        solvers.push_back(std::make_unique<Solver>());
+        configure(*solvers.back());
+        // Every level of a multilevel solve takes its own time limit, so its runtime cannot be budgeted
+        solvers.back()->multilevel.threshold = 0;
+    }
+}
+
+double BatchScheduler::difficulty(const ModelFeatures& features)
+{
+    // Branching over the binaries dominates; the square root keeps a few large scenes from starving the small
+    // ones. Equality rows chain objects together and narrow the feasible region.
+    return std::sqrt(1.0 + features.binaries + features.nonconvex_terms) * (1 + features.equality_ratio);
+}
+
+void BatchScheduler::forEachWorker(const std::function<void(size_t, Solver&)>& fn)
+{
+    std::vector<std::thread> workers;
+    for (size_t k = 0; k < solvers.size(); ++k)
+        workers.emplace_back([&fn, k, solver = solvers[k].get()]() { fn(k, *solver); });
+    for (auto& t : workers)
+        t.join();
+}
+
+std::vector<nlohmann::json> BatchScheduler::run(const std::vector<std::string>& scenes)
+{
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    auto elapsed = [start] { return std::chrono::duration<double>(Clock::now() - start).count(); };
+    size_t n = scenes.size();
+    std::vector<nlohmann::json> records(n);
+
+    // Estimation: the models are only recorded, so this takes a small part of the budget
+    std::vector<double> weights(n, 1);
+    std::atomic<size_t> next_estimate{ 0 };
+    forEachWorker([&](size_t, Solver& solver) {
+        for (size_t i = next_estimate++; i < n; i = next_estimate++) {
+            std::string error;
+            // Scenes that fail here fail again when solved and are reported then
+            try {
+                if (solver.loadSceneText(scenes[i], error))
+                    weights[i] = difficulty(solver.estimateFeatures());
+            }
+            catch (...) {}
+        }
+    });
+    std::cerr << "Estimated " << n << " scenes in " << elapsed() << " s" << std::endl;
+
+    // Hardest first, so the longest solves do not start last
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return weights[a] > weights[b]; });
+
+    std::mutex mutex;
+    std::condition_variable cores_freed;
+    size_t next_scene = 0;
+    int free_cores = params.cores;
+    // Weight of the scenes not started yet, and the threads and end time of every worker's current slice
+    double unstarted = std::accumulate(weights.begin(), weights.end(), 0.0);
+    std::vector<std::pair<int, double>> slices(solvers.size(), { 0, 0.0 });
+
+    // Seconds for a slice of a scene of weight w on threads threads: its share, against the scenes still waiting,
+    // of the core-seconds left before the deadline that no running slice holds. Called with the lock held.
+    auto grant = [&](double w, int threads) {
+        double now = elapsed(), remaining = std::max(0.0, params.budget - now);
+        double held = 0;
+        for (const auto& slice : slices)
+            held += slice.first * std::max(0.0, slice.second - now);
+        double available = std::max(0.0, params.cores * remaining - held);
+        return std::min(available * w / (w + unstarted) / threads, remaining);
+    };
+
+    forEachWorker([&](size_t worker, Solver& solver) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cores_freed.wait(lock, [&] { return next_scene == n || free_cores > 0; });
+            if (next_scene == n)
+                return;
+            size_t i = order[next_scene++];
+            unstarted -= weights[i];
+            // The tail of the batch, with few scenes left, gets the cores the waiting scenes no longer need
+            double share = weights[i] / (weights[i] + unstarted);
+            int threads = std::clamp(static_cast<int>(std::lround(params.cores * share)), 1, free_cores);
+            double seconds = std::max(grant(weights[i], threads), params.min_slice);
+            free_cores -= threads;
+            slices[worker] = { threads, elapsed() + seconds };
+            lock.unlock();
+
+            auto scene_start = Clock::now();
+            nlohmann::json record, schedule;
+            schedule["difficulty"] = weights[i];
+            schedule["threads"] = threads;
+            schedule["slices"] = nlohmann::json::array();
+            std::string error;
+            try {
+                if (!solver.loadSceneText(scenes[i], error)) {
+                    record = SceneStream::errorRecord(error);
+                }
+                else {
+                    solver.budget.seconds = seconds;
+                    solver.budget.threads = threads;
+                    solver.solve();
+                    schedule["slices"].push_back(seconds);
+                    // Time goes on to scenes whose gap still shrinks; a first incumbent counts as progress
+                    double gap = std::numeric_limits<double>::infinity();
+                    while (solver.progress.time_limited && (std::isinf(solver.progress.gap) ||
+                        solver.progress.gap <= gap * (1 - params.min_gap_reduction))) {
+                        gap = solver.progress.gap;
+                        lock.lock();
+                        slices[worker].second = elapsed();
+                        seconds = grant(weights[i], threads);
+                        if (seconds < params.min_slice) {
+                            lock.unlock();
+                            break;
+                        }
+                        slices[worker].second = elapsed() + seconds;
+                        lock.unlock();
+                        if (!solver.resume(seconds))
+                            break;
+                        schedule["slices"].push_back(seconds);
+                    }
+                    record = solver.result();
+                    record["solved"] = solver.hasLayout();
+                    schedule["gap"] = std::isinf(solver.progress.gap) ? nlohmann::json() : nlohmann::json(solver.progress.gap);
+                }
+            }
+            catch (const GRBException& e) {
+                record = SceneStream::errorRecord(e.getMessage());
+            }
+            // The worker must go on to free its cores and take the next scene
+            catch (const std::exception& e) {
+                record = SceneStream::errorRecord(e.what());
+            }
+            record["record"] = i;
+            record["runtime"] = std::chrono::duration<double>(Clock::now() - scene_start).count();
+            record["schedule"] = schedule;
+
+            lock.lock();
+            records[i] = std::move(record);
+            free_cores += threads;
+            slices[worker] = { 0, 0.0 };
+            cores_freed.notify_all();
+        }
+    });
+    return records;
+}
@@ -1,11 +1,18 @@
 #include "GraphProcessor.h"
+#include <algorithm>
+#include <boost/dynamic_bitset.hpp>
 #include <iostream>
+#include <limits>
+#include <tuple>
 
 GraphProcessor::GraphProcessor() {
     edgetypes = { LeftOf, RightOf, FrontOf, Behind, Above, Under, CloseBy, AlignWith };
     edgenames = { "LeftOf", "RightOf", "FrontOf", "Behind", "Above", "Under", "CloseBy", "AlignWith" };
     orientations = { UP, DOWN, LEFT, RIGHT, FRONT, BACK };
     orientationnames = { "UP", "DOWN", "LEFT", "RIGHT", "FRONT", "BACK" };
+    edge_rejected = false;
+    merged_edges = 0;
+    implied_edges = 0;
 }
 
 GraphProcessor::~GraphProcessor() {}
@@ -34,83 +41,339 @@ EdgeType GraphProcessor::oppositeEdgeType(EdgeType e) {
     return e;
 }
 
-void GraphProcessor::removeCycles(SceneGraph& g, EdgeType edge_type) {
-    EdgeTypeFilter edge_filter(g, edge_type);
-    boost::filtered_graph<SceneGraph, EdgeTypeFilter> filtered_g(g, edge_filter);
+bool GraphProcessor::normalizeEdge(EdgeProperties& ep) {
+    // RightOf/Behind/Under are stored as the reversed LeftOf/FrontOf/Above edge
+    if (ep.type == RightOf || ep.type == Behind || ep.type == Under) {
+        ep.type = oppositeEdgeType(ep.type);
+        return true;
+    }
+    return false;
+}
 
-    // Find the strongly connected component
-    std::vector<int> component(num_vertices(filtered_g));
-    int num = boost::strong_components(filtered_g, &component[0]);
+// Components up to this size get an exact feedback arc set (DP over vertex subsets),
+// larger ones fall back to the Eades-Lin-Smyth ordering heuristic.
+static const int kExactFASLimit = 12;
+// Maximum number of ranked removal plans reported to the user.
+static const int kMaxPlans = 5;
 
-    // Find rings
-    std::vector<std::vector<EdgeDescriptor>> cycles_edges;
-    for (int i = 0; i < num; ++i) {
-        std::vector<EdgeDescriptor> edges_to_remove;
-        for (const auto &e : boost::make_iterator_range(edges(filtered_g))) {
-            if (component[source(e, filtered_g)] == i && component[target(e, filtered_g)] == i) {
-                edges_to_remove.push_back(e);
+std::vector<int> GraphProcessor::exactFeedbackArcSet(int n, const std::vector<std::pair<int, int>>& arcs, const std::vector<int>& weights) {
+    // w[v][u]: total weight of arcs v->u, which become backward arcs when u is placed before v
+    std::vector<std::vector<int>> w(n, std::vector<int>(n, 0));
+    for (size_t i = 0; i < arcs.size(); ++i) {
+        if (arcs[i].first != arcs[i].second)
+            w[arcs[i].first][arcs[i].second] += weights[i];
+    }
+    const int full = 1 << n;
+    const int inf = std::numeric_limits<int>::max();
+    std::vector<int> dp(full, inf), choice(full, -1);
+    dp[0] = 0;
+    for (int S = 0; S < full; ++S) {
+        if (dp[S] == inf) continue;
+        for (int v = 0; v < n; ++v) {
+            if (S & (1 << v)) continue;
+            int cost = dp[S];
+            for (int u = 0; u < n; ++u) {
+                if (S & (1 << u)) cost += w[v][u];
+            }
+            int T = S | (1 << v);
+            if (cost < dp[T]) {
+                dp[T] = cost;
+                choice[T] = v;
             }
         }
-        if (!edges_to_remove.empty()) {
-            cycles_edges.push_back(edges_to_remove);
+    }
+    // Recover the optimal ordering back to front
+    std::vector<int> position(n);
+    for (int S = full - 1, k = n - 1; S != 0; --k) {
+        position[choice[S]] = k;
+        S &= ~(1 << choice[S]);
+    }
+    std::vector<int> fas;
+    for (size_t i = 0; i < arcs.size(); ++i) {
+        if (position[arcs[i].first] >= position[arcs[i].second])
+            fas.push_back(static_cast<int>(i));
+    }
+    return fas;
+}
+
+std::vector<int> GraphProcessor::greedyFeedbackArcSet(int n, const std::vector<std::pair<int, int>>& arcs, const std::vector<int>& weights) {
+    std::vector<std::vector<int>> out_arcs(n), in_arcs(n);
+    std::vector<long long> out_w(n, 0), in_w(n, 0);
+    for (size_t i = 0; i < arcs.size(); ++i) {
+        if (arcs[i].first == arcs[i].second) continue;
+        out_arcs[arcs[i].first].push_back(static_cast<int>(i));
+        in_arcs[arcs[i].second].push_back(static_cast<int>(i));
+        out_w[arcs[i].first] += weights[i];
+        in_w[arcs[i].second] += weights[i];
+    }
+    std::vector<bool> removed(n, false);
+    std::vector<int> head, tail;
+    auto take = [&](int v) {
+        removed[v] = true;
+        for (int a : out_arcs[v]) in_w[arcs[a].second] -= weights[a];
+        for (int a : in_arcs[v]) out_w[arcs[a].first] -= weights[a];
+    };
+    for (int left = n; left > 0; ) {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int v = 0; v < n; ++v) {
+                if (removed[v]) continue;
+                if (out_w[v] == 0) { tail.push_back(v); take(v); --left; changed = true; }
+                else if (in_w[v] == 0) { head.push_back(v); take(v); --left; changed = true; }
+            }
+        }
+        if (left == 0) break;
+        int best = -1;
+        for (int v = 0; v < n; ++v) {
+            if (!removed[v] && (best < 0 || out_w[v] - in_w[v] > out_w[best] - in_w[best]))
+                best = v;
+        }
+        head.push_back(best);
+        take(best);
+        --left;
+    }
+    std::vector<int> position(n);
+    int k = 0;
+    for (int v : head) position[v] = k++;
+    for (auto it = tail.rbegin(); it != tail.rend(); ++it) position[*it] = k++;
+    std::vector<int> fas;
+    for (size_t i = 0; i < arcs.size(); ++i) {
+        if (position[arcs[i].first] >= position[arcs[i].second])
+            fas.push_back(static_cast<int>(i));
+    }
+    return fas;
+}
+
+void GraphProcessor::minimizeFeedbackArcSet(int n, const std::vector<std::pair<int, int>>& arcs, std::vector<int>& fas) {
+    // Put back every removed arc that does not close a cycle, so no plan removes more than it needs to
+    std::vector<bool> kept(arcs.size(), true);
+    for (int a : fas) kept[a] = false;
+    std::vector<std::vector<int>> adj(n);
+    for (size_t i = 0; i < arcs.size(); ++i) {
+        if (kept[i]) adj[arcs[i].first].push_back(arcs[i].second);
+    }
+    std::vector<int> minimal;
+    for (int a : fas) {
+        int u = arcs[a].first, v = arcs[a].second;
+        bool closes_cycle = (u == v);
+        std::vector<bool> visited(n, false);
+        std::vector<int> stack = { v };
+        while (!closes_cycle && !stack.empty()) {
+            int x = stack.back();
+            stack.pop_back();
+            if (x == u) closes_cycle = true;
+            else if (!visited[x]) {
+                visited[x] = true;
+                for (int y : adj[x]) stack.push_back(y);
+            }
+        }
+        if (closes_cycle)
+            minimal.push_back(a);
+        else
+            adj[u].push_back(v);
+    }
+    fas = minimal;
+}
+
+std::vector<int> GraphProcessor::feedbackArcSet(int n, const std::vector<std::pair<int, int>>& arcs, const std::vector<int>& weights) {
+    std::vector<int> fas = n <= kExactFASLimit ? exactFeedbackArcSet(n, arcs, weights) : greedyFeedbackArcSet(n, arcs, weights);
+    minimizeFeedbackArcSet(n, arcs, fas);
+    std::sort(fas.begin(), fas.end());
+    return fas;
+}
+
+void GraphProcessor::removeCycles(SceneGraph& g) {
+    const std::vector<EdgeType> cycle_types = { LeftOf, FrontOf, Above };
+    const int n = static_cast<int>(num_vertices(g));
+
+    // Strongly connected components of each normalized edge type
+    std::vector<std::vector<int>> component(cycle_types.size(), std::vector<int>(n));
+    std::vector<int> num_components(cycle_types.size());
+    for (size_t t = 0; t < cycle_types.size(); ++t) {
+        EdgeTypeFilter edge_filter(g, cycle_types[t]);
+        boost::filtered_graph<SceneGraph, EdgeTypeFilter> filtered_g(g, edge_filter);
+        num_components[t] = boost::strong_components(filtered_g, &component[t][0]);
+    }
+
+    // Bucket the edges of every type by component in a single sweep
+    std::vector<std::vector<std::vector<EdgeDescriptor>>> buckets(cycle_types.size());
+    for (size_t t = 0; t < cycle_types.size(); ++t)
+        buckets[t].resize(num_components[t]);
+    for (const auto& e : boost::make_iterator_range(edges(g))) {
+        auto it = std::find(cycle_types.begin(), cycle_types.end(), g[e].type);
+        if (it == cycle_types.end()) continue;
+        size_t t = it - cycle_types.begin();
+        int c = component[t][source(e, g)];
+        if (c == component[t][target(e, g)])
+            buckets[t][c].push_back(e);
+    }
+
+    // Ranked candidate removal sets per cyclic component: the minimum one first, then the best
+    // alternatives that keep one of its edges
+    std::vector<std::vector<std::vector<EdgeDescriptor>>> candidates;
+    std::vector<int> local(n, -1);
+    for (size_t t = 0; t < cycle_types.size(); ++t) {
+        for (const auto& bucket : buckets[t]) {
+            if (bucket.empty()) continue;
+            std::vector<VertexDescriptor> members;
+            std::vector<std::pair<int, int>> arcs;
+            for (const auto& e : bucket) {
+                for (VertexDescriptor v : { source(e, g), target(e, g) }) {
+                    if (local[v] < 0) {
+                        local[v] = static_cast<int>(members.size());
+                        members.push_back(v);
+                    }
+                }
+                arcs.push_back(std::make_pair(local[source(e, g)], local[target(e, g)]));
+            }
+            for (VertexDescriptor v : members) local[v] = -1;
+
+            int m = static_cast<int>(members.size());
+            std::vector<int> weights(arcs.size(), 1);
+            std::vector<std::vector<int>> sets = { feedbackArcSet(m, arcs, weights) };
+            for (size_t k = 0; k < sets[0].size() && static_cast<int>(sets.size()) < kMaxPlans; ++k) {
+                int keep = sets[0][k];
+                if (arcs[keep].first == arcs[keep].second) continue;
+                std::vector<int> forced(weights);
+                forced[keep] = static_cast<int>(arcs.size()) + 1;
+                std::vector<int> alt = feedbackArcSet(m, arcs, forced);
+                if (std::find(alt.begin(), alt.end(), keep) == alt.end() && std::find(sets.begin(), sets.end(), alt) == sets.end())
+                    sets.push_back(alt);
+            }
+            std::stable_sort(sets.begin(), sets.end(), [](const std::vector<int>& a, const std::vector<int>& b) {
+                return a.size() < b.size();
+            });
+
+            std::vector<std::vector<EdgeDescriptor>> component_candidates;
+            for (const auto& set : sets) {
+                std::vector<EdgeDescriptor> removal;
+                for (int a : set) removal.push_back(bucket[a]);
+                component_candidates.push_back(removal);
+            }
+            candidates.push_back(component_candidates);
         }
     }
+    if (candidates.empty())
+        return;
+
+    // Plan 0 takes the best set of every component; each further plan swaps one component to an
+    // alternative, ranked by the total number of removed edges.
+    size_t base_size = 0;
+    for (const auto& c : candidates) base_size += c[0].size();
+    std::vector<std::tuple<size_t, size_t, size_t>> swaps;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        for (size_t j = 1; j < candidates[i].size(); ++j)
+            swaps.push_back(std::make_tuple(base_size - candidates[i][0].size() + candidates[i][j].size(), i, j));
+    }
+    std::stable_sort(swaps.begin(), swaps.end(), [](const auto& a, const auto& b) {
+        return std::get<0>(a) < std::get<0>(b);
+    });
+    swaps.insert(swaps.begin(), std::make_tuple(base_size, candidates.size(), size_t(0)));
+    if (swaps.size() > kMaxPlans)
+        swaps.resize(kMaxPlans);
 
-    // Report cycles
-    if (!cycles_edges.empty()) {
-        conflict_info = "Cycles found, please choose to remove conflict constraints: \n";
-        plan_info = {};
-        
-        for (const auto &edges : cycles_edges) {
-            for (auto i = 0; i < edges.size(); ++i) {
-                plan_info.push_back("Plan " + std::to_string(i) + ": Remove edge " + g[source(edges[i], g)].label + " " + edgenames[g[edges[i]].type] + " " + g[target(edges[i], g)].label + "\n");
+    conflict_info = "Cycles found in " + std::to_string(candidates.size()) + " group(s) of relations, please choose to remove conflict constraints: \n";
+    plan_info = {};
+    for (size_t p = 0; p < swaps.size(); ++p) {
+        std::string plan = "Plan " + std::to_string(p) + ": Remove edge" + (std::get<0>(swaps[p]) > 1 ? "s " : " ");
+        bool first = true;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            const auto& removal = i == std::get<1>(swaps[p]) ? candidates[i][std::get<2>(swaps[p])] : candidates[i][0];
+            for (const auto& e : removal) {
+                plan += (first ? "" : ", ") + g[source(e, g)].label + " " + edgenames[g[e].type] + " " + g[target(e, g)].label;
+                first = false;
             }
         }
+        plan_info.push_back(plan + "\n");
+    }
+}
+
+void GraphProcessor::markImpliedEdges(SceneGraph& g, EdgeType edge_type) {
+    // Transitive reduction of the ordering DAG: an inequality edge u -> v is implied when v is also
+    // reachable through another child of u. Equality (touching) edges are never implied.
+    const size_t n = boost::num_vertices(g);
+    std::vector<std::vector<std::pair<VertexDescriptor, EdgeDescriptor>>> children(n);
+    std::vector<int> in_degree(n, 0);
+    for (const auto& e : boost::make_iterator_range(edges(g))) {
+        if (g[e].type != edge_type) continue;
+        children[source(e, g)].push_back(std::make_pair(target(e, g), e));
+        ++in_degree[target(e, g)];
+    }
+    std::vector<VertexDescriptor> order;
+    for (VertexDescriptor v = 0; v < n; ++v) {
+        if (in_degree[v] == 0) order.push_back(v);
+    }
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (const auto& c : children[order[i]]) {
+            if (--in_degree[c.first] == 0) order.push_back(c.first);
+        }
+    }
+    // Cycles of this type are reported by removeCycles; leave the graph as is
+    if (order.size() != n)
+        return;
+
+    std::vector<boost::dynamic_bitset<>> reach(n);
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        boost::dynamic_bitset<> through_children(n);
+        for (const auto& c : children[*it]) {
+            through_children |= reach[c.first];
+        }
+        for (const auto& c : children[*it]) {
+            if (through_children[c.first] && g[c.second].distance >= 0) {
+                g[c.second].implied = true;
+                ++implied_edges;
+            }
+        }
+        for (const auto& c : children[*it]) {
+            through_children.set(c.first);
+        }
+        reach[*it] = std::move(through_children);
     }
-    
 }
 
 SceneGraph GraphProcessor::process(const SceneGraph& inputGraph, const Boundary& boundary)
 {
-    SceneGraph outputGraph = inputGraph;
-    // Find and work with rings in each type of edge
-    std::vector<std::pair<VertexDescriptor, VertexDescriptor>> edges_to_reverse, edges_to_remove;
-	std::vector<EdgeProperties> new_edge_properties, removed_edge_properties;
+    SceneGraph outputGraph;
+    VertexIterator vi, vi_end;
+    for (boost::tie(vi, vi_end) = boost::vertices(inputGraph); vi != vi_end; ++vi) {
+        boost::add_vertex(inputGraph[*vi], outputGraph);
+    }
+    // Normalize RightOf/Behind/Under and merge parallel duplicates in a single pass. Above/CloseBy edges each add
+    // an offset term to the objective, so only those with the same offset are duplicates.
+    std::map<std::tuple<VertexDescriptor, VertexDescriptor, int, int, std::vector<double>>, EdgeDescriptor> kept_edges;
+    merged_edges = 0;
     EdgeIterator ei, ei_end;
-    for (boost::tie(ei, ei_end) = boost::edges(outputGraph); ei != ei_end; ++ei) {
-		VertexDescriptor v1 = boost::source(*ei, outputGraph), v2 = boost::target(*ei, outputGraph);
-        EdgeProperties ep = outputGraph[*ei];
-        if (ep.type == RightOf) {
-            ep.type = LeftOf;
-        }
-        else if (ep.type == Behind) {
-            ep.type = FrontOf;
+    for (boost::tie(ei, ei_end) = boost::edges(inputGraph); ei != ei_end; ++ei) {
+        VertexDescriptor v1 = boost::source(*ei, inputGraph), v2 = boost::target(*ei, inputGraph);
+        EdgeProperties ep = inputGraph[*ei];
+        ep.implied = false;
+        if (normalizeEdge(ep)) {
+            std::swap(v1, v2);
         }
-        else if (ep.type == Under) {
-            ep.type = Above;
-        }
-        else {
+        std::vector<double> offset;
+        if (ep.type == Above || ep.type == CloseBy)
+            offset = ep.xyoffset.empty() ? std::vector<double>{ 0, 0 } : ep.xyoffset;
+        auto key = std::make_tuple(v1, v2, static_cast<int>(ep.type), ep.type == AlignWith ? ep.align_edge : -1, offset);
+        auto it = kept_edges.find(key);
+        if (it == kept_edges.end()) {
+            kept_edges[key] = boost::add_edge(v1, v2, ep, outputGraph).first;
             continue;
         }
-        edges_to_reverse.push_back(std::make_pair(v1, v2));
-		new_edge_properties.push_back(ep);
-    }
-    for (size_t i = 0; i < edges_to_reverse.size(); ++i) {
-        boost::graph_traits<SceneGraph>::out_edge_iterator oe_i, oe_end;
-        for (boost::tie(oe_i, oe_end) = boost::out_edges(edges_to_reverse[i].first, outputGraph); oe_i != oe_end; ++oe_i) {
-            if (boost::target(*oe_i, outputGraph) == edges_to_reverse[i].second && outputGraph[*oe_i].type == oppositeEdgeType(new_edge_properties[i].type)) { 
-                boost::remove_edge(*oe_i, outputGraph);
-                break;
-            }
+        // Keep the tightest distance: touching (negative) first, then the smallest gap
+        EdgeProperties& kept = outputGraph[it->second];
+        if (kept.distance >= 0 && (ep.distance < 0 || ep.distance < kept.distance)) {
+            kept.distance = ep.distance;
         }
-        //boost::remove_edge(edges_to_reverse[i].first, edges_to_reverse[i].second, outputGraph);
-        boost::add_edge(edges_to_reverse[i].second, edges_to_reverse[i].first, new_edge_properties[i], outputGraph);
+        ++merged_edges;
     }
-    for (EdgeType edgetype : {LeftOf, FrontOf, Above}) {
-        removeCycles(outputGraph, edgetype);
+    removeCycles(outputGraph);
+    cycleDetector.reset(outputGraph);
+    implied_edges = 0;
+    for (EdgeType edgetype : {LeftOf, FrontOf}) {
+        markImpliedEdges(outputGraph, edgetype);
     }
     // Find the contradiction between boundary constraints and position/orientation constraints
-    VertexIterator vi, vi_end;
     std::vector<VertexDescriptor> vertices_to_remove;
     for (boost::tie(vi, vi_end) = boost::vertices(outputGraph); vi != vi_end; ++vi) {
         Orientation o_vi = outputGraph[*vi].orientation;
@@ -141,4 +404,110 @@ void GraphProcessor::reset()
 {
     conflict_info = "";
     plan_info = {};
-}
\ No newline at end of file
+    standing_conflict_info.clear();
+    standing_plan_info.clear();
+    edge_rejected = false;
+    merged_edges = 0;
+    implied_edges = 0;
+}
+
+bool GraphProcessor::insertEdge(SceneGraph& g, VertexDescriptor source, VertexDescriptor target, EdgeProperties ep)
+{
+    clearRejection();
+    std::string relation = g[source].label + " " + edgenames[ep.type] + " " + g[target].label;
+    if (normalizeEdge(ep))
+        std::swap(source, target);
+
+    std::vector<VertexDescriptor> cycle;
+    if (cycleDetector.insertEdge(source, target, ep.type, cycle)) {
+        boost::add_edge(source, target, ep, g);
+        return true;
+    }
+    // cycle holds target -> ... -> source, closed by the new edge. The conflicts of the scene itself are kept
+    // aside until the rejection is cleared.
+    edge_rejected = true;
+    standing_conflict_info = conflict_info;
+    standing_plan_info = plan_info;
+    std::string path = g[source].label;
+    for (VertexDescriptor v : cycle)
+        path += " " + edgenames[ep.type] + " " + g[v].label;
+    conflict_info = "Cycle found when adding " + relation + ": " + path + ", please choose a plan: \n";
+    plan_info = {};
+    plan_info.push_back("Plan 0: Discard new edge " + relation + "\n");
+    for (size_t i = 0; i + 1 < cycle.size(); ++i) {
+        plan_info.push_back("Plan " + std::to_string(i + 1) + ": Remove edge " + g[cycle[i]].label + " " + edgenames[ep.type] + " " + g[cycle[i + 1]].label + "\n");
+    }
+    return false;
+}
+
+void GraphProcessor::eraseEdge(SceneGraph& g, VertexDescriptor source, VertexDescriptor target, EdgeType type)
+{
+    EdgeProperties ep;
+    ep.type = type;
+    if (normalizeEdge(ep))
+        std::swap(source, target);
+    boost::graph_traits<SceneGraph>::out_edge_iterator oe_i, oe_end;
+    for (boost::tie(oe_i, oe_end) = boost::out_edges(source, g); oe_i != oe_end; ++oe_i) {
+        if (boost::target(*oe_i, g) == target && g[*oe_i].type == ep.type) {
+            boost::remove_edge(*oe_i, g);
+            cycleDetector.removeEdge(source, target, ep.type);
+            break;
+        }
+    }
+    // The removed edge may have been the path that made another edge of its type redundant
+    for (const auto& e : boost::make_iterator_range(edges(g))) {
+        if (g[e].type == ep.type) g[e].implied = false;
+    }
+    clearRejection();
+}
+
+void GraphProcessor::clearRejection()
+{
+    // A rejection only describes the edit that caused it
+    if (!edge_rejected)
+        return;
+    conflict_info = std::move(standing_conflict_info);
+    plan_info = std::move(standing_plan_info);
+    standing_conflict_info.clear();
+    standing_plan_info.clear();
+    edge_rejected = false;
+}
+
+void GraphProcessor::insertVertex(SceneGraph& g, const VertexProperties& vp)
+{
+    boost::add_vertex(vp, g);
+    cycleDetector.addVertex();
+}
+
+std::vector<std::vector<VertexDescriptor>> GraphProcessor::findInterchangeableClasses(const SceneGraph& g)
+{
+    // (outgoing, type, distance, xyoffset, align_edge, other endpoint)
+    typedef std::tuple<bool, int, double, std::vector<double>, int, VertexDescriptor> EdgeSignature;
+    typedef std::tuple<std::string, std::vector<double>, std::vector<double>, std::vector<double>, std::vector<double>,
+        std::vector<int>, std::vector<EdgeSignature>> VertexSignature;
+
+    const size_t n = boost::num_vertices(g);
+    std::vector<std::vector<EdgeSignature>> incident(n);
+    for (const auto& e : boost::make_iterator_range(edges(g))) {
+        const EdgeProperties& ep = g[e];
+        VertexDescriptor s = source(e, g), t = target(e, g);
+        incident[s].push_back(std::make_tuple(true, static_cast<int>(ep.type), ep.distance, ep.xyoffset, ep.align_edge, t));
+        incident[t].push_back(std::make_tuple(false, static_cast<int>(ep.type), ep.distance, ep.xyoffset, ep.align_edge, s));
+    }
+    std::map<VertexSignature, std::vector<VertexDescriptor>> groups;
+    for (VertexDescriptor v = 0; v < n; ++v) {
+        const VertexProperties& vp = g[v];
+        std::sort(incident[v].begin(), incident[v].end());
+        std::vector<int> flags = { vp.boundary, static_cast<int>(vp.corner), static_cast<int>(vp.orientation), vp.on_floor, vp.hanging };
+        groups[std::make_tuple(vp.label, vp.target_size, vp.size_tolerance, vp.target_pos, vp.pos_tolerance, flags, incident[v])].push_back(v);
+    }
+    std::vector<std::vector<VertexDescriptor>> classes;
+    for (auto& group : groups) {
+        if (group.second.size() < 2) continue;
+        std::sort(group.second.begin(), group.second.end(), [&g](VertexDescriptor a, VertexDescriptor b) {
+            return g[a].id < g[b].id;
+        });
+        classes.push_back(group.second);
+    }
+    return classes;
+}
@@ -0,0 +1,73 @@
+#include "GurobiBackend.h"
+
+void GurobiBackend::attach(GRBModel& model) {
+    this->model = &model;
+    clear();
+}
+
+int GurobiBackend::addVars(int count, const double* lb, const double* ub, const char* types, const std::string* names) {
+    int first = numVars();
+    std::vector<double> obj(count, 0.0);
+    GRBVar* added = model->addVars(lb, ub, obj.data(), types, names, count);
+    vars.insert(vars.end(), added, added + count);
+    delete[] added;
+    return first;
+}
+
+void GurobiBackend::addRows(const RowBuffer& buffer) {
+    if (buffer.size() == 0)
+        return;
+    std::vector<GRBLinExpr> exprs(buffer.size());
+    std::vector<GRBVar> row_vars;
+    for (size_t k = 0; k < buffer.size(); ++k) {
+        size_t begin = buffer.starts[k], end = buffer.starts[k + 1];
+        row_vars.resize(end - begin);
+        for (size_t t = begin; t < end; ++t)
+            row_vars[t - begin] = vars[buffer.vars[t]];
+        exprs[k].addTerms(buffer.coeffs.data() + begin, row_vars.data(), static_cast<int>(end - begin));
+    }
+    delete[] model->addConstrs(exprs.data(), buffer.senses.data(), buffer.rhs.data(), buffer.names.data(),
+        static_cast<int>(buffer.size()));
+    rows += static_cast<int>(buffer.size());
+}
+
+void GurobiBackend::setObjective(ObjectiveAssembler& objective) {
+    const auto& quadratic = objective.quadraticTerms();
+    std::vector<double> coeffs(quadratic.size());
+    std::vector<GRBVar> vars1(quadratic.size()), vars2(quadratic.size());
+    for (size_t k = 0; k < quadratic.size(); ++k) {
+        coeffs[k] = quadratic[k].coeff;
+        vars1[k] = vars[quadratic[k].a];
+        vars2[k] = vars[quadratic[k].b];
+    }
+    GRBQuadExpr expr(objective.constantTerm());
+    expr.addTerms(coeffs.data(), vars1.data(), vars2.data(), static_cast<int>(coeffs.size()));
+
+    const auto& linear = objective.linearTerms();
+    coeffs.resize(linear.size());
+    std::vector<GRBVar> linear_vars(linear.size());
+    for (size_t k = 0; k < linear.size(); ++k) {
+        coeffs[k] = linear[k].second;
+        linear_vars[k] = vars[linear[k].first];
+    }
+    expr.addTerms(coeffs.data(), linear_vars.data(), static_cast<int>(coeffs.size()));
+    model->setObjective(expr, GRB_MINIMIZE);
+}
+
+bool GurobiBackend::optimize() {
+    model->optimize();
+    return model->get(GRB_IntAttr_SolCount) > 0;
+}
+
+double GurobiBackend::value(int var) const {
+    return vars[var].get(GRB_DoubleAttr_X);
+}
+
+double GurobiBackend::objectiveValue() const {
+    return model->get(GRB_DoubleAttr_ObjVal);
+}
+
+void GurobiBackend::clear() {
+    vars.clear();
+    rows = 0;
+}
@@ -0,0 +1,150 @@
+#include "IncrementalCycleDetector.h"
+#include <algorithm>
+
+IncrementalCycleDetector::IncrementalCycleDetector() : orders(3) {}
+
+IncrementalCycleDetector::~IncrementalCycleDetector() {}
+
+int IncrementalCycleDetector::typeIndex(EdgeType type) const {
+    switch (type) {
+    case LeftOf: return 0;
+    case FrontOf: return 1;
+    case Above: return 2;
+    default: return -1;
+    }
+}
+
+void IncrementalCycleDetector::reset(const SceneGraph& g) {
+    int n = static_cast<int>(boost::num_vertices(g));
+    for (auto& t : orders) {
+        t.ord.resize(n);
+        t.vertex_at.resize(n);
+        for (int i = 0; i < n; ++i) {
+            t.ord[i] = i;
+            t.vertex_at[i] = i;
+        }
+        t.out_edges.assign(n, {});
+        t.in_edges.assign(n, {});
+    }
+    visited.assign(n, false);
+    parent.assign(n, -1);
+    std::vector<VertexDescriptor> cycle;
+    EdgeIterator ei, ei_end;
+    for (boost::tie(ei, ei_end) = boost::edges(g); ei != ei_end; ++ei) {
+        insertEdge(boost::source(*ei, g), boost::target(*ei, g), g[*ei].type, cycle);
+    }
+}
+
+void IncrementalCycleDetector::addVertex() {
+    for (auto& t : orders) {
+        int n = static_cast<int>(t.ord.size());
+        t.ord.push_back(n);
+        t.vertex_at.push_back(n);
+        t.out_edges.push_back({});
+        t.in_edges.push_back({});
+    }
+    visited.push_back(false);
+    parent.push_back(-1);
+}
+
+bool IncrementalCycleDetector::forwardSearch(TypeOrder& t, int v, int upper, int x) {
+    // Iterative DFS over the affected region ord(y) .. ord(x); stops as soon as x is reached
+    std::vector<int> stack = { v };
+    visited[v] = true;
+    forward_visited.push_back(v);
+    while (!stack.empty()) {
+        int u = stack.back();
+        stack.pop_back();
+        for (int w : t.out_edges[u]) {
+            if (w == x) {
+                parent[w] = u;
+                return true;
+            }
+            if (!visited[w] && t.ord[w] < upper) {
+                visited[w] = true;
+                forward_visited.push_back(w);
+                parent[w] = u;
+                stack.push_back(w);
+            }
+        }
+    }
+    return false;
+}
+
+void IncrementalCycleDetector::backwardSearch(TypeOrder& t, int v, int lower) {
+    std::vector<int> stack = { v };
+    visited[v] = true;
+    backward_visited.push_back(v);
+    while (!stack.empty()) {
+        int u = stack.back();
+        stack.pop_back();
+        for (int w : t.in_edges[u]) {
+            if (!visited[w] && t.ord[w] > lower) {
+                visited[w] = true;
+                backward_visited.push_back(w);
+                stack.push_back(w);
+            }
+        }
+    }
+}
+
+void IncrementalCycleDetector::reorder(TypeOrder& t) {
+    // Vertices reaching x are moved in front of the vertices reachable from y, reusing their slots
+    auto by_ord = [&t](int a, int b) { return t.ord[a] < t.ord[b]; };
+    std::sort(forward_visited.begin(), forward_visited.end(), by_ord);
+    std::sort(backward_visited.begin(), backward_visited.end(), by_ord);
+    std::vector<int> slots, affected(backward_visited);
+    affected.insert(affected.end(), forward_visited.begin(), forward_visited.end());
+    for (int v : affected) {
+        slots.push_back(t.ord[v]);
+        visited[v] = false;
+    }
+    std::sort(slots.begin(), slots.end());
+    for (size_t i = 0; i < affected.size(); ++i) {
+        t.ord[affected[i]] = slots[i];
+        t.vertex_at[slots[i]] = affected[i];
+    }
+}
+
+bool IncrementalCycleDetector::insertEdge(VertexDescriptor source, VertexDescriptor target, EdgeType type, std::vector<VertexDescriptor>& cycle) {
+    int k = typeIndex(type);
+    if (k < 0)
+        return true;
+    TypeOrder& t = orders[k];
+    int x = static_cast<int>(source), y = static_cast<int>(target);
+    cycle.clear();
+    if (x == y) {
+        cycle.push_back(source);
+        return false;
+    }
+    if (t.ord[y] < t.ord[x]) {
+        forward_visited.clear();
+        backward_visited.clear();
+        if (forwardSearch(t, y, t.ord[x], x)) {
+            for (int v : forward_visited) visited[v] = false;
+            for (int v = x; v != y; v = parent[v]) cycle.push_back(v);
+            cycle.push_back(y);
+            std::reverse(cycle.begin(), cycle.end());
+            return false;
+        }
+        backwardSearch(t, x, t.ord[y]);
+        reorder(t);
+    }
+    t.out_edges[x].push_back(y);
+    t.in_edges[y].push_back(x);
+    return true;
+}
+
+void IncrementalCycleDetector::removeEdge(VertexDescriptor source, VertexDescriptor target, EdgeType type) {
+    // Deleting an edge never invalidates a topological order, so only the adjacency changes
+    int k = typeIndex(type);
+    if (k < 0)
+        return;
+    TypeOrder& t = orders[k];
+    auto& out = t.out_edges[source];
+    auto it = std::find(out.begin(), out.end(), static_cast<int>(target));
+    if (it != out.end()) out.erase(it);
+    auto& in = t.in_edges[target];
+    it = std::find(in.begin(), in.end(), static_cast<int>(source));
+    if (it != in.end()) in.erase(it);
+}
@@ -0,0 +1,461 @@
+#include "LayoutModel.h"
+#include <algorithm>
+#include <iostream>
+
+LayoutModel::LayoutModel(const SceneGraph& g, const Boundary& boundary) : vertical_decoupled(false), g(g), boundary(boundary) {}
+
+bool LayoutModel::hasPath(VertexDescriptor start, VertexDescriptor target) const {
+    size_t n = boost::num_vertices(g);
+    std::vector<bool> visited_1(n, false), visited_3(n, false), visited_4(n, false), visited_5(n, false), visited_6(n, false);
+    return dfsCheckPath(start, target, LeftOf, visited_1) || dfsCheckPath(start, target, RightOf, visited_1) ||
+        dfsCheckPath(start, target, FrontOf, visited_3) || dfsCheckPath(start, target, Behind, visited_4) ||
+        dfsCheckPath(start, target, Above, visited_5) || dfsCheckPath(start, target, Under, visited_6);
+}
+
+bool LayoutModel::dfsCheckPath(VertexDescriptor u, VertexDescriptor target, EdgeType required_type, std::vector<bool>& visited) const {
+    if (g[u].id == g[target].id)
+        return true;
+    visited[g[u].id] = true;
+    for (const auto& edge : boost::make_iterator_range(boost::out_edges(u, g))) {
+        VertexDescriptor v = boost::target(edge, g);
+        if (!visited[g[v].id] && g[edge].type == required_type && dfsCheckPath(v, target, required_type, visited))
+            return true;
+    }
+    return false;
+}
+
+void LayoutModel::analyze(int threads) {
+    this->threads = threads;
+    size_t num_vertices = boost::num_vertices(g);
+    // Pairs with no ordering path between them. The path searches only read g, so rows of the pair matrix are
+    // split across threads and the per-thread lists joined in order.
+    ModelBuilder builder(threads);
+    std::vector<std::vector<std::pair<VertexDescriptor, VertexDescriptor>>> chunk_pairs(builder.chunks(num_vertices, 16));
+    builder.forEachChunk(num_vertices, 16, [&](size_t chunk, size_t begin, size_t end) {
+        for (size_t u = begin; u < end; ++u) {
+            for (size_t v = 0; v < num_vertices; ++v) {
+                if (g[u].id < g[v].id && !hasPath(u, v) && !hasPath(v, u))
+                    chunk_pairs[chunk].push_back(std::make_pair(u, v));
+            }
+        }
+    });
+    overlap_pairs.clear();
+    for (const auto& pairs : chunk_pairs)
+        overlap_pairs.insert(overlap_pairs.end(), pairs.begin(), pairs.end());
+
+    // Bound every object's lowest possible top and highest possible bottom from the floor/ceiling flags
+    // and the size/position tolerances. Object a can only be stacked above b if bottom_max[a] >= top_min[b].
+    double floor_z = boundary.origin_pos[2], ceiling_z = boundary.origin_pos[2] + boundary.size[2];
+    std::vector<double> bottom_max(num_vertices), top_min(num_vertices);
+    VertexIterator vi, vi_end;
+    for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
+        const VertexProperties& vp = g[*vi];
+        double h_min = 0, z_min = floor_z, z_max = ceiling_z;
+        if (!vp.target_size.empty() && !vp.size_tolerance.empty())
+            h_min = std::max(0.0, vp.target_size[2] - vp.size_tolerance[2]);
+        if (!vp.target_pos.empty() && !vp.pos_tolerance.empty()) {
+            z_min = std::max(z_min, vp.target_pos[2] - vp.pos_tolerance[2]);
+            z_max = std::min(z_max, vp.target_pos[2] + vp.pos_tolerance[2]);
+        }
+        double b_max = std::min(z_max - h_min / 2, ceiling_z - h_min);
+        double t_min = std::max(z_min + h_min / 2, floor_z + h_min);
+        if (vp.on_floor)
+            b_max = floor_z;
+        if (vp.hanging)
+            t_min = ceiling_z;
+        bottom_max[vp.id] = b_max;
+        top_min[vp.id] = t_min;
+    }
+    const double eps = 1e-9;
+    vertical_branch.assign(overlap_pairs.size(), false);
+    vertical_decoupled = true;
+    for (size_t p = 0; p < overlap_pairs.size(); ++p) {
+        int i = g[overlap_pairs[p].first].id, j = g[overlap_pairs[p].second].id;
+        vertical_branch[p] = bottom_max[i] >= top_min[j] - eps || bottom_max[j] >= top_min[i] - eps;
+        if (vertical_branch[p])
+            vertical_decoupled = false;
+    }
+    if (vertical_decoupled)
+        std::cout << "Vertical axis is decoupled: solving z/h separately" << std::endl;
+}
+
+void LayoutModel::build(ModelBackend& model, ModelBackend& vertical, GraphProcessor& processor, bool break_symmetry) {
+    int num_vertices = static_cast<int>(boost::num_vertices(g));
+    double M = boundary.size[0] + boundary.size[1] + boundary.size[2];
+    features = ModelFeatures();
+    features.vertices = num_vertices;
+    features.overlap_pairs = static_cast<int>(overlap_pairs.size());
+    features.vertical_decoupled = vertical_decoupled;
+
+    x.assign(num_vertices, -1);
+    y.assign(num_vertices, -1);
+    z.assign(num_vertices, -1);
+    l.assign(num_vertices, -1);
+    w.assign(num_vertices, -1);
+    h.assign(num_vertices, -1);
+    for (int i = 0; i < num_vertices; ++i) {
+        std::string id = std::to_string(i);
+        x[i] = model.addVar(boundary.origin_pos[0], boundary.origin_pos[0] + boundary.size[0], kContinuous, "x_" + id);
+        y[i] = model.addVar(boundary.origin_pos[1], boundary.origin_pos[1] + boundary.size[1], kContinuous, "y_" + id);
+        l[i] = model.addVar(0.0, boundary.size[0], kContinuous, "l_" + id);
+        w[i] = model.addVar(0.0, boundary.size[1], kContinuous, "w_" + id);
+        z[i] = vertical.addVar(boundary.origin_pos[2], boundary.origin_pos[2] + boundary.size[2], kContinuous, "z_" + id);
+        h[i] = vertical.addVar(0.0, boundary.size[2], kContinuous, "h_" + id);
+    }
+    RowBuffer rows, vertical_rows;
+
+    // Inside Constraints & tolerance Constraint
+    VertexIterator vi, vi_end;
+    for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
+        const VertexProperties& vp = g[*vi];
+        int i = vp.id;
+        std::string object = "Object_" + std::to_string(i);
+        rows.add({ { x[i], 1 }, { l[i], -0.5 } }, kGreaterEqual, boundary.origin_pos[0], "Inside_" + object + "_x_left");
+        rows.add({ { x[i], 1 }, { l[i], 0.5 } }, kLessEqual, boundary.origin_pos[0] + boundary.size[0], "Inside_" + object + "_x_right");
+        rows.add({ { y[i], 1 }, { w[i], -0.5 } }, kGreaterEqual, boundary.origin_pos[1], "Inside_" + object + "_y_back");
+        rows.add({ { y[i], 1 }, { w[i], 0.5 } }, kLessEqual, boundary.origin_pos[1] + boundary.size[1], "Inside_" + object + "_y_front");
+        vertical_rows.add({ { z[i], 1 }, { h[i], -0.5 } }, kGreaterEqual, boundary.origin_pos[2], "Inside_" + object + "_z_bottom");
+        vertical_rows.add({ { z[i], 1 }, { h[i], 0.5 } }, kLessEqual, boundary.origin_pos[2] + boundary.size[2], "Inside_" + object + "_z_top");
+        if (!vp.pos_tolerance.empty() && !vp.target_pos.empty()) {
+            rows.add({ { x[i], 1 } }, kGreaterEqual, vp.target_pos[0] - vp.pos_tolerance[0], "Pos_Tolerance_" + object + "_x_left");
+            rows.add({ { x[i], 1 } }, kLessEqual, vp.target_pos[0] + vp.pos_tolerance[0], "Pos_Tolerance_" + object + "_x_right");
+            rows.add({ { y[i], 1 } }, kGreaterEqual, vp.target_pos[1] - vp.pos_tolerance[1], "Pos_Tolerance_" + object + "_y_back");
+            rows.add({ { y[i], 1 } }, kLessEqual, vp.target_pos[1] + vp.pos_tolerance[1], "Pos_Tolerance_" + object + "_y_front");
+            vertical_rows.add({ { z[i], 1 } }, kGreaterEqual, vp.target_pos[2] - vp.pos_tolerance[2], "Pos_Tolerance_" + object + "_z_bottom");
+            vertical_rows.add({ { z[i], 1 } }, kLessEqual, vp.target_pos[2] + vp.pos_tolerance[2], "Pos_Tolerance_" + object + "_z_top");
+        }
+        if (!vp.size_tolerance.empty() && !vp.target_size.empty()) {
+            rows.add({ { l[i], 1 } }, kGreaterEqual, vp.target_size[0] - vp.size_tolerance[0], "Size_Tolerance_" + object + "_l_min");
+            rows.add({ { l[i], 1 } }, kLessEqual, vp.target_size[0] + vp.size_tolerance[0], "Size_Tolerance_" + object + "_l_max");
+            rows.add({ { w[i], 1 } }, kGreaterEqual, vp.target_size[1] - vp.size_tolerance[1], "Size_Tolerance_" + object + "_w_min");
+            rows.add({ { w[i], 1 } }, kLessEqual, vp.target_size[1] + vp.size_tolerance[1], "Size_Tolerance_" + object + "_w_max");
+            vertical_rows.add({ { h[i], 1 } }, kGreaterEqual, vp.target_size[2] - vp.size_tolerance[2], "Size_Tolerance_" + object + "_h_min");
+            vertical_rows.add({ { h[i], 1 } }, kLessEqual, vp.target_size[2] + vp.size_tolerance[2], "Size_Tolerance_" + object + "_h_max");
+        }
+    }
+    // On floor and Hanging Constraints
+    for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
+        int i = g[*vi].id;
+        if (g[*vi].on_floor)
+            vertical_rows.add({ { z[i], 1 }, { h[i], -0.5 } }, kEqual, boundary.origin_pos[2], "On_Floor_Object_" + std::to_string(i));
+    }
+    for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
+        int i = g[*vi].id;
+        if (g[*vi].hanging)
+            vertical_rows.add({ { z[i], 1 }, { h[i], 0.5 } }, kEqual, boundary.origin_pos[2] + boundary.size[2], "Hanging_Object_" + std::to_string(i));
+    }
+
+    // Adjacency Constraints
+    EdgeIterator ei, ei_end;
+    for (boost::tie(ei, ei_end) = boost::edges(g); ei != ei_end; ++ei) {
+        int s = g[boost::source(*ei, g)].id, t = g[boost::target(*ei, g)].id;
+        // Orderings implied by a chain of other edges only contribute their objective term
+        if (g[*ei].implied)
+            continue;
+        char ordering = g[*ei].distance >= 0 ? kLessEqual : kEqual;
+        std::string name = "Object_" + std::to_string(s) + "_" + processor.edgenames[g[*ei].type] + "_Object_" + std::to_string(t);
+        switch (g[*ei].type)
+        {
+        case LeftOf:
+            // x_s + l_s/2 <= x_t - l_t/2
+            rows.add({ { x[s], 1 }, { l[s], 0.5 }, { x[t], -1 }, { l[t], 0.5 } }, ordering, 0, name);
+            break;
+        case RightOf:
+            // x_s - l_s/2 >= x_t + l_t/2
+            rows.add({ { x[t], 1 }, { l[t], 0.5 }, { x[s], -1 }, { l[s], 0.5 } }, ordering, 0, name);
+            break;
+        case Behind:
+            rows.add({ { y[s], 1 }, { w[s], 0.5 }, { y[t], -1 }, { w[t], 0.5 } }, ordering, 0, name);
+            break;
+        case FrontOf:
+            rows.add({ { y[t], 1 }, { w[t], 0.5 }, { y[s], -1 }, { w[s], 0.5 } }, ordering, 0, name);
+            break;
+        case Under:
+            vertical_rows.add({ { z[s], 1 }, { h[s], 0.5 }, { z[t], -1 }, { h[t], 0.5 } }, kEqual, 0, name);
+            break;
+        case Above:
+            vertical_rows.add({ { z[t], 1 }, { h[t], 0.5 }, { z[s], -1 }, { h[s], 0.5 } }, kEqual, 0, name);
+            break;
+        case CloseBy:
+        {
+            // A binary set to 1 enforces its row, 0 leaves it slack by M. R: the left side of s reaches the right
+            // side of t; L: the right side of s reaches the left side of t; F/B likewise along y. ieqe enforces at
+            // most one of them; the distance to the partner comes from the offset term of the objective.
+            int L = model.addVar(0, 1, kBinary, ""), R = model.addVar(0, 1, kBinary, ""),
+                F = model.addVar(0, 1, kBinary, ""), B = model.addVar(0, 1, kBinary, "");
+            features.closeby_binaries += 4;
+            rows.add({ { x[s], 1 }, { l[s], -0.5 }, { x[t], -1 }, { l[t], -0.5 }, { R, M } }, kLessEqual, M, name + "ieqa");
+            rows.add({ { x[s], 1 }, { l[s], 0.5 }, { x[t], -1 }, { l[t], 0.5 }, { L, -M } }, kGreaterEqual, -M, name + "ieqb");
+            rows.add({ { y[s], 1 }, { w[s], -0.5 }, { y[t], -1 }, { w[t], -0.5 }, { F, M } }, kLessEqual, M, name + "ieqc");
+            rows.add({ { y[s], 1 }, { w[s], 0.5 }, { y[t], -1 }, { w[t], 0.5 }, { B, -M } }, kGreaterEqual, -M, name + "ieqd");
+            rows.add({ { L, 1 }, { R, 1 }, { F, 1 }, { B, 1 } }, kLessEqual, 1, name + "ieqe");
+            break;
+        }
+        case AlignWith:
+            switch (g[*ei].align_edge)
+            {
+            case 0:
+                rows.add({ { y[s], 1 }, { w[s], -0.5 }, { y[t], -1 }, { w[t], 0.5 } }, kEqual, 0, name);
+                break;
+            case 1:
+                rows.add({ { x[s], 1 }, { l[s], 0.5 }, { x[t], -1 }, { l[t], -0.5 } }, kEqual, 0, name);
+                break;
+            case 2:
+                rows.add({ { y[s], 1 }, { w[s], 0.5 }, { y[t], -1 }, { w[t], -0.5 } }, kEqual, 0, name);
+                break;
+            case 3:
+                rows.add({ { x[s], 1 }, { l[s], -0.5 }, { x[t], -1 }, { l[t], 0.5 } }, kEqual, 0, name);
+                break;
+            case 4:
+                vertical_rows.add({ { z[s], 1 }, { h[s], -0.5 }, { z[t], -1 }, { h[t], -0.5 } }, kEqual, 0, name);
+                break;
+            case 5:
+                vertical_rows.add({ { z[s], 1 }, { h[s], 0.5 }, { z[t], -1 }, { h[t], 0.5 } }, kEqual, 0, name);
+                break;
+            default:break;
+            }
+            break;
+        default:break;
+        }
+    }
+
+    // Symmetry breaking: members of an interchangeable class are ordered by x, so the lower id can
+    // never be strictly right of a higher id in the same class
+    std::vector<int> symmetry_class(num_vertices, -1);
+    symmetry_rows.clear();
+    symmetry_fixed_vars.clear();
+    layout_binaries.clear();
+    if (break_symmetry) {
+        auto classes = processor.findInterchangeableClasses(g);
+        for (size_t c = 0; c < classes.size(); ++c) {
+            for (size_t k = 0; k < classes[c].size(); ++k) {
+                symmetry_class[g[classes[c][k]].id] = static_cast<int>(c);
+                if (k > 0) {
+                    int a = g[classes[c][k - 1]].id, b = g[classes[c][k]].id;
+                    symmetry_rows.push_back("Symmetry_Object_" + std::to_string(a) + "_Object_" + std::to_string(b));
+                    rows.add({ { x[a], 1 }, { x[b], -1 } }, kLessEqual, 0, symmetry_rows.back());
+                }
+            }
+        }
+        if (!classes.empty())
+            std::cout << "Symmetry breaking on " << classes.size() << " class(es) of interchangeable objects" << std::endl;
+    }
+
+    // Non overlap Constraints
+    // Pairs that can never be vertically separated only get the four horizontal branches. The pair binaries get
+    // consecutive handles, so several threads can write the rows into their own buffers before anything is added.
+    size_t first = model.numVars();
+    std::vector<size_t> pair_vars(overlap_pairs.size() + 1, first);
+    for (size_t p = 0; p < overlap_pairs.size(); ++p)
+        pair_vars[p + 1] = pair_vars[p] + (vertical_branch[p] ? 6 : 4);
+    size_t num_pair_vars = pair_vars.back() - first;
+    std::vector<double> pair_lb(num_pair_vars, 0), pair_ub(num_pair_vars, 1);
+    std::vector<char> pair_types(num_pair_vars, kBinary);
+    std::vector<std::string> pair_names(num_pair_vars);
+    ModelBuilder builder(threads);
+    std::vector<RowBuffer> pair_rows(builder.chunks(overlap_pairs.size(), 256));
+    builder.forEachChunk(overlap_pairs.size(), 256, [&](size_t chunk, size_t begin, size_t end) {
+        RowBuffer& out = pair_rows[chunk];
+        for (size_t p = begin; p < end; ++p) {
+            int i = g[overlap_pairs[p].first].id, j = g[overlap_pairs[p].second].id;
+            std::string name = "NonOverlap_Object_" + std::to_string(i) + "and_Object_" + std::to_string(j);
+            std::string suffix = std::to_string(i) + "_" + std::to_string(j);
+            // Handles of sigma_L, sigma_R, sigma_F, sigma_B, sigma_U, sigma_D, and their slots in the pair arrays
+            int L = static_cast<int>(pair_vars[p]), R = L + 1, F = L + 2, B = L + 3, U = L + 4, D = L + 5;
+            size_t slot = pair_vars[p] - first;
+            pair_names[slot] = "sigma_L_" + suffix;
+            pair_names[slot + 1] = "sigma_R_" + suffix;
+            pair_names[slot + 2] = "sigma_F_" + suffix;
+            pair_names[slot + 3] = "sigma_B_" + suffix;
+            if (symmetry_class[i] >= 0 && symmetry_class[i] == symmetry_class[j])
+                pair_ub[slot + 1] = 0;
+            // x_i - l_i/2 >= x_j + l_j/2 - M(1 - sigma_R) and so on, with the variables moved to the left
+            out.add({ { x[i], 1 }, { l[i], -0.5 }, { x[j], -1 }, { l[j], -0.5 }, { R, -M } }, kGreaterEqual, -M, name + "R");
+            out.add({ { x[i], 1 }, { l[i], 0.5 }, { x[j], -1 }, { l[j], 0.5 }, { L, M } }, kLessEqual, M, name + "L");
+            out.add({ { y[i], 1 }, { w[i], -0.5 }, { y[j], -1 }, { w[j], -0.5 }, { F, -M } }, kGreaterEqual, -M, name + "F");
+            out.add({ { y[i], 1 }, { w[i], 0.5 }, { y[j], -1 }, { w[j], 0.5 }, { B, M } }, kLessEqual, M, name + "B");
+            if (vertical_branch[p]) {
+                pair_names[slot + 4] = "sigma_U_" + suffix;
+                pair_names[slot + 5] = "sigma_D_" + suffix;
+                out.add({ { z[i], 1 }, { h[i], -0.5 }, { z[j], -1 }, { h[j], -0.5 }, { U, -M } }, kGreaterEqual, -M, name + "U");
+                out.add({ { z[i], 1 }, { h[i], 0.5 }, { z[j], -1 }, { h[j], 0.5 }, { D, M } }, kLessEqual, M, name + "D");
+                out.add({ { L, 1 }, { R, 1 }, { F, 1 }, { B, 1 }, { U, 1 }, { D, 1 } }, kGreaterEqual, 1, name);
+            }
+            else {
+                out.add({ { L, 1 }, { R, 1 }, { F, 1 }, { B, 1 } }, kGreaterEqual, 1, name);
+            }
+        }
+    });
+    if (num_pair_vars > 0)
+        model.addVars(static_cast<int>(num_pair_vars), pair_lb.data(), pair_ub.data(), pair_types.data(), pair_names.data());
+    for (size_t k = 0; k < num_pair_vars; ++k) {
+        layout_binaries.push_back(static_cast<int>(first + k));
+        if (pair_ub[k] == 0)
+            symmetry_fixed_vars.push_back(static_cast<int>(first + k));
+    }
+    // Rows go in the order they were formulated, so the solver sees the same model as before
+    model.addRows(rows);
+    for (const auto& buffer : pair_rows)
+        model.addRows(buffer);
+    rows = RowBuffer();
+
+    // Boundary Constraints
+    for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
+        int i = g[*vi].id, wall = g[*vi].boundary;
+        if (wall < 0)
+            continue;
+        double x1 = boundary.points[wall][0], x2 = boundary.points[(wall + 1) % boundary.Orientations.size()][0];
+        double y1 = boundary.points[wall][1], y2 = boundary.points[(wall + 1) % boundary.Orientations.size()][1];
+        double x1_ = std::min(x1, x2), x2_ = std::max(x1, x2);
+        double y1_ = std::min(y1, y2), y2_ = std::max(y1, y2);
+        std::string name = "Boundary_Object_" + std::to_string(i);
+        switch (boundary.Orientations[wall])
+        {
+        case LEFT:
+            rows.add({ { x[i], 1 }, { l[i], -0.5 } }, kEqual, x1_, name + "_Left_eq");
+            // Here we assume that on boundary means at least half of length is on the wall
+            rows.add({ { y[i], 1 } }, kGreaterEqual, y1_, name + "_Left_ieq");
+            rows.add({ { y[i], 1 } }, kLessEqual, y2_, name + "_Left_ieqq");
+            break;
+        case RIGHT:
+            rows.add({ { x[i], 1 }, { l[i], 0.5 } }, kEqual, x1_, name + "_Right_eq");
+            rows.add({ { y[i], 1 } }, kGreaterEqual, y1_, name + "_Right_ieq");
+            rows.add({ { y[i], 1 } }, kLessEqual, y2_, name + "_Right_ieqq");
+            break;
+        case FRONT:
+            rows.add({ { y[i], 1 }, { w[i], 0.5 } }, kEqual, y1_, name + "_Front_eq");
+            rows.add({ { x[i], 1 } }, kGreaterEqual, x1_, name + "_Front_ieq");
+            rows.add({ { x[i], 1 } }, kLessEqual, x2_, name + "_Front_ieqq");
+            break;
+        case BACK:
+            rows.add({ { y[i], 1 }, { w[i], -0.5 } }, kEqual, y1_, name + "_Back_eq");
+            rows.add({ { x[i], 1 } }, kGreaterEqual, x1_, name + "_Back_ieq");
+            rows.add({ { x[i], 1 } }, kLessEqual, x2_, name + "_Back_ieqq");
+            break;
+        default:break;
+        }
+    }
+
+    // Corner Constraints
+    // One binary per candidate corner of the room; the chosen one fixes the matching corner of the object
+    for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
+        int i = g[*vi].id;
+        const std::vector<int>* corners;
+        std::string name;
+        double sx, sy;
+        switch (g[*vi].corner)
+        {
+        case BOTTOMLEFT: corners = &boundary.BLcorner; name = "BottomLeft"; sx = -0.5; sy = -0.5; break;
+        case BOTTOMRIGHT: corners = &boundary.BRcorner; name = "BottomRight"; sx = 0.5; sy = -0.5; break;
+        case TOPLEFT: corners = &boundary.TLcorner; name = "TopLeft"; sx = -0.5; sy = 0.5; break;
+        case TOPRIGHT: corners = &boundary.TRcorner; name = "TopRight"; sx = 0.5; sy = 0.5; break;
+        default: continue;
+        }
+        name += "_Corner_of_Object_" + std::to_string(i);
+        std::vector<std::pair<int, double>> posx = { { x[i], 1 }, { l[i], sx } }, posy = { { y[i], 1 }, { w[i], sy } }, cors;
+        for (size_t k = 0; k < corners->size(); ++k) {
+            int cor = model.addVar(0.0, 1.0, kBinary, "corner_" + std::to_string(i) + "_" + std::to_string(k));
+            layout_binaries.push_back(cor);
+            features.corner_binaries++;
+            posx.push_back({ cor, -boundary.points[(*corners)[k]][0] });
+            posy.push_back({ cor, -boundary.points[(*corners)[k]][1] });
+            cors.push_back({ cor, 1 });
+        }
+        rows.add(cors, kEqual, 1, name + "eqa");
+        rows.add(posx, kEqual, 0, name + "eqb");
+        rows.add(posy, kEqual, 0, name + "eqc");
+    }
+
+    model.addRows(rows);
+    vertical.addRows(vertical_rows);
+    buildObjective();
+}
+
+void LayoutModel::buildObjective() {
+    // Notice that hyperparameters are the weights of area, size error, position error, adjacency error.
+    // The four components are kept unweighted so a sweep can re-weight them without rebuilding the model;
+    // obj2z/obj3z collect the vertical size/position terms so they can go to the vertical model.
+    ObjectiveAssembler obj1, obj2, obj3, obj4, obj2z, obj3z;
+    obj1.addConstant(1);
+    int num2 = 0, num3 = 0, num4 = 0;
+    double sx = 1 / (boundary.size[0] * boundary.size[0]), sy = 1 / (boundary.size[1] * boundary.size[1]),
+        sz = 1 / (boundary.size[2] * boundary.size[2]);
+    VertexIterator vi, vi_end;
+    for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
+        const VertexProperties& vp = g[*vi];
+        int i = vp.id;
+        bool area_flag = true;
+        for (const auto& e : boost::make_iterator_range(boost::out_edges(*vi, g))) {
+            if (g[e].type == Above || g[e].type == Under) {
+                area_flag = false;
+                break;
+            }
+        }
+        if (area_flag) {
+            obj1.addQuadratic(l[i], w[i], -1 / boundary.size[0] / boundary.size[1]);
+            features.nonconvex_terms++;
+        }
+        if (!vp.target_size.empty()) {
+            obj2.addSquare({ { l[i], 1 } }, -vp.target_size[0], sx);
+            obj2.addSquare({ { w[i], 1 } }, -vp.target_size[1], sy);
+            obj2z.addSquare({ { h[i], 1 } }, -vp.target_size[2], sz);
+            num2++;
+        }
+        if (!vp.target_pos.empty()) {
+            obj3.addSquare({ { x[i], 1 } }, -vp.target_pos[0], sx);
+            obj3.addSquare({ { y[i], 1 } }, -vp.target_pos[1], sy);
+            obj3z.addSquare({ { z[i], 1 } }, -vp.target_pos[2], sz);
+            num3++;
+        }
+    }
+    EdgeIterator ei, ei_end;
+    for (boost::tie(ei, ei_end) = boost::edges(g); ei != ei_end; ++ei) {
+        int s = g[boost::source(*ei, g)].id, t = g[boost::target(*ei, g)].id;
+        std::vector<double> offset = g[*ei].xyoffset;
+        if (offset.empty())
+            offset = { 0, 0 };
+        double d = g[*ei].distance;
+        if (d >= 0) {
+            switch (g[*ei].type)
+            {
+            case LeftOf:
+                // (x_t - l_t/2 - x_s - l_s/2 - d)^2
+                obj4.addSquare({ { x[t], 1 }, { l[t], -0.5 }, { x[s], -1 }, { l[s], -0.5 } }, -d, sx);
+                num4++;
+                break;
+            case RightOf:
+                obj4.addSquare({ { x[s], 1 }, { l[s], -0.5 }, { x[t], -1 }, { l[t], -0.5 } }, -d, sx);
+                num4++;
+                break;
+            case Behind:
+                obj4.addSquare({ { y[t], 1 }, { w[t], -0.5 }, { y[s], -1 }, { w[s], -0.5 } }, -d, sy);
+                num4++;
+                break;
+            case FrontOf:
+                obj4.addSquare({ { y[s], 1 }, { w[s], -0.5 }, { y[t], -1 }, { w[t], -0.5 } }, -d, sy);
+                num4++;
+                break;
+            default:break;
+            }
+        }
+        if (g[*ei].type == Above || g[*ei].type == Under || g[*ei].type == CloseBy) {
+            obj4.addSquare({ { x[s], 1 }, { x[t], -1 } }, -offset[0], sx);
+            obj4.addSquare({ { y[s], 1 }, { y[t], -1 } }, -offset[1], sy);
+            num4++;
+        }
+    }
+    if (num2 > 0) {
+        obj2.scale(1.0 / num2);
+        obj2z.scale(1.0 / num2);
+    }
+    if (num3 > 0) {
+        obj3.scale(1.0 / num3);
+        obj3z.scale(1.0 / num3);
+    }
+    if (num4 > 0)
+        obj4.scale(1.0 / num4);
+    for (auto* term : { &obj1, &obj2, &obj3, &obj4, &obj2z, &obj3z })
+        term->merge();
+    objective_terms = { obj1, obj2, obj3, obj4 };
+    vertical_objective_terms = { ObjectiveAssembler(), obj2z, obj3z, ObjectiveAssembler() };
+}
@@ -0,0 +1,285 @@
+#include "LayoutVerifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+const double kMissing = std::numeric_limits<double>::quiet_NaN();
+
+double component(const std::vector<double>& v, size_t k) {
+    return v.size() > k ? v[k] : kMissing;
+}
+}
+
+LayoutVerifier::LayoutVerifier(double tolerance) : tolerance(tolerance) {}
+
+void LayoutVerifier::report(const std::string& constraint, double magnitude)
+{
+    if (magnitude > tolerance)
+        violations.push_back({ constraint, magnitude });
+}
+
+void LayoutVerifier::load(const SceneGraph& g)
+{
+    size_t n = boost::num_vertices(g);
+    for (auto* v : { &x, &y, &z, &l, &w, &h, &target_x, &target_y, &target_z, &pos_tol_x, &pos_tol_y, &pos_tol_z,
+        &target_l, &target_w, &target_h, &size_tol_l, &size_tol_w, &size_tol_h })
+        v->assign(n, kMissing);
+    ids.assign(n, -1);
+    for (size_t i = 0; i < n; ++i) {
+        const VertexProperties& vp = g[boost::vertex(i, g)];
+        ids[i] = vp.id;
+        if (vp.pos.size() < 3 || vp.size.size() < 3)
+            continue;
+        x[i] = vp.pos[0]; y[i] = vp.pos[1]; z[i] = vp.pos[2];
+        l[i] = vp.size[0]; w[i] = vp.size[1]; h[i] = vp.size[2];
+        if (!vp.target_pos.empty() && !vp.pos_tolerance.empty()) {
+            target_x[i] = component(vp.target_pos, 0); target_y[i] = component(vp.target_pos, 1); target_z[i] = component(vp.target_pos, 2);
+            pos_tol_x[i] = component(vp.pos_tolerance, 0); pos_tol_y[i] = component(vp.pos_tolerance, 1); pos_tol_z[i] = component(vp.pos_tolerance, 2);
+        }
+        if (!vp.target_size.empty() && !vp.size_tolerance.empty()) {
+            target_l[i] = component(vp.target_size, 0); target_w[i] = component(vp.target_size, 1); target_h[i] = component(vp.target_size, 2);
+            size_tol_l[i] = component(vp.size_tolerance, 0); size_tol_w[i] = component(vp.size_tolerance, 1); size_tol_h[i] = component(vp.size_tolerance, 2);
+        }
+    }
+}
+
+void LayoutVerifier::checkObjects(const SceneGraph& g, const Boundary& boundary)
+{
+    size_t n = x.size();
+    const double lo[3] = { boundary.origin_pos[0], boundary.origin_pos[1], boundary.origin_pos[2] };
+    const double hi[3] = { lo[0] + boundary.size[0], lo[1] + boundary.size[1], lo[2] + boundary.size[2] };
+    const std::vector<double>* center[3] = { &x, &y, &z };
+    const std::vector<double>* extent[3] = { &l, &w, &h };
+    const std::vector<double>* target_pos[3] = { &target_x, &target_y, &target_z };
+    const std::vector<double>* pos_tol[3] = { &pos_tol_x, &pos_tol_y, &pos_tol_z };
+    const std::vector<double>* target_size[3] = { &target_l, &target_w, &target_h };
+    const std::vector<double>* size_tol[3] = { &size_tol_l, &size_tol_w, &size_tol_h };
+    const char* axis_low[3] = { "_x_left", "_y_back", "_z_bottom" };
+    const char* axis_high[3] = { "_x_right", "_y_front", "_z_top" };
+    const char* size_name[3] = { "_l", "_w", "_h" };
+
+    // Each pass is a branch-free loop over one axis; only the rare reports branch
+    std::vector<double> below(n), above(n);
+    for (int a = 0; a < 3; ++a) {
+        const double* c = center[a]->data();
+        const double* e = extent[a]->data();
+        for (size_t i = 0; i < n; ++i) {
+            below[i] = lo[a] - (c[i] - e[i] / 2);
+            above[i] = (c[i] + e[i] / 2) - hi[a];
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (below[i] > tolerance)
+                report("Inside_Object_" + std::to_string(ids[i]) + axis_low[a], below[i]);
+            if (above[i] > tolerance)
+                report("Inside_Object_" + std::to_string(ids[i]) + axis_high[a], above[i]);
+        }
+
+        const double* tp = target_pos[a]->data();
+        const double* pt = pos_tol[a]->data();
+        for (size_t i = 0; i < n; ++i) {
+            below[i] = (tp[i] - pt[i]) - c[i];
+            above[i] = c[i] - (tp[i] + pt[i]);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (below[i] > tolerance)
+                report("Pos_Tolerance_Object_" + std::to_string(ids[i]) + axis_low[a], below[i]);
+            if (above[i] > tolerance)
+                report("Pos_Tolerance_Object_" + std::to_string(ids[i]) + axis_high[a], above[i]);
+        }
+
+        const double* ts = target_size[a]->data();
+        const double* st = size_tol[a]->data();
+        for (size_t i = 0; i < n; ++i) {
+            below[i] = (ts[i] - st[i]) - e[i];
+            above[i] = e[i] - (ts[i] + st[i]);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (below[i] > tolerance)
+                report("Size_Tolerance_Object_" + std::to_string(ids[i]) + size_name[a] + "_min", below[i]);
+            if (above[i] > tolerance)
+                report("Size_Tolerance_Object_" + std::to_string(ids[i]) + size_name[a] + "_max", above[i]);
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        const VertexProperties& vp = g[boost::vertex(i, g)];
+        if (vp.on_floor)
+            report("On_Floor_Object_" + std::to_string(ids[i]), std::abs(z[i] - h[i] / 2 - lo[2]));
+        if (vp.hanging)
+            report("Hanging_Object_" + std::to_string(ids[i]), std::abs(z[i] + h[i] / 2 - hi[2]));
+    }
+}
+
+void LayoutVerifier::checkRelations(const SceneGraph& g)
+{
+    EdgeIterator ei, ei_end;
+    for (boost::tie(ei, ei_end) = boost::edges(g); ei != ei_end; ++ei) {
+        const EdgeProperties& ep = g[*ei];
+        size_t s = boost::source(*ei, g), t = boost::target(*ei, g);
+        std::string name;
+        // lhs <= rhs for orderings with a distance, lhs == rhs otherwise
+        double lhs = 0, rhs = 0;
+        bool inequality = ep.distance >= 0;
+        switch (ep.type) {
+        case LeftOf:
+            name = "Object_" + std::to_string(ids[s]) + "_LeftOf_Object_" + std::to_string(ids[t]);
+            lhs = x[s] + l[s] / 2; rhs = x[t] - l[t] / 2;
+            break;
+        case RightOf:
+            name = "Object_" + std::to_string(ids[s]) + "_RightOf_Object_" + std::to_string(ids[t]);
+            lhs = x[t] + l[t] / 2; rhs = x[s] - l[s] / 2;
+            break;
+        case Behind:
+            name = "Object_" + std::to_string(ids[s]) + "_Behind_Object_" + std::to_string(ids[t]);
+            lhs = y[s] + w[s] / 2; rhs = y[t] - w[t] / 2;
+            break;
+        case FrontOf:
+            name = "Object_" + std::to_string(ids[s]) + "_FrontOf_Object_" + std::to_string(ids[t]);
+            lhs = y[t] + w[t] / 2; rhs = y[s] - w[s] / 2;
+            break;
+        case Under:
+            name = "Object_" + std::to_string(ids[s]) + "_Under_Object_" + std::to_string(ids[t]);
+            lhs = z[s] + h[s] / 2; rhs = z[t] - h[t] / 2;
+            inequality = false;
+            break;
+        case Above:
+            name = "Object_" + std::to_string(ids[s]) + "_Above_Object_" + std::to_string(ids[t]);
+            lhs = z[t] + h[t] / 2; rhs = z[s] - h[s] / 2;
+            inequality = false;
+            break;
+        case AlignWith:
+            name = "Object_" + std::to_string(ids[s]) + "_AlignWith_Object_" + std::to_string(ids[t]);
+            inequality = false;
+            switch (ep.align_edge) {
+            case 0: lhs = y[s] - w[s] / 2; rhs = y[t] - w[t] / 2; break;
+            case 1: lhs = x[s] + l[s] / 2; rhs = x[t] + l[t] / 2; break;
+            case 2: lhs = y[s] + w[s] / 2; rhs = y[t] + w[t] / 2; break;
+            case 3: lhs = x[s] - l[s] / 2; rhs = x[t] - l[t] / 2; break;
+            case 4: lhs = z[s] - h[s] / 2; rhs = z[t] + h[t] / 2; break;
+            case 5: lhs = z[s] + h[s] / 2; rhs = z[t] - h[t] / 2; break;
+            default: continue;
+            }
+            break;
+        default:
+            continue;
+        }
+        report(name, inequality ? lhs - rhs : std::abs(lhs - rhs));
+    }
+}
+
+void LayoutVerifier::checkWallsAndCorners(const SceneGraph& g, const Boundary& boundary)
+{
+    size_t walls = boundary.Orientations.size();
+    for (size_t i = 0; i < x.size(); ++i) {
+        const VertexProperties& vp = g[boost::vertex(i, g)];
+        std::string id = std::to_string(ids[i]);
+        if (vp.boundary >= 0 && static_cast<size_t>(vp.boundary) < walls) {
+            const auto& p1 = boundary.points[vp.boundary];
+            const auto& p2 = boundary.points[(vp.boundary + 1) % walls];
+            double x1 = std::min(p1[0], p2[0]), x2 = std::max(p1[0], p2[0]);
+            double y1 = std::min(p1[1], p2[1]), y2 = std::max(p1[1], p2[1]);
+            switch (boundary.Orientations[vp.boundary]) {
+            case LEFT:
+                report("Boundary_Object_" + id + "_Left_eq", std::abs(x[i] - l[i] / 2 - x1));
+                report("Boundary_Object_" + id + "_Left_ieq", y1 - y[i]);
+                report("Boundary_Object_" + id + "_Left_ieqq", y[i] - y2);
+                break;
+            case RIGHT:
+                report("Boundary_Object_" + id + "_Right_eq", std::abs(x[i] + l[i] / 2 - x1));
+                report("Boundary_Object_" + id + "_Right_ieq", y1 - y[i]);
+                report("Boundary_Object_" + id + "_Right_ieqq", y[i] - y2);
+                break;
+            case FRONT:
+                report("Boundary_Object_" + id + "_Front_eq", std::abs(y[i] + w[i] / 2 - y1));
+                report("Boundary_Object_" + id + "_Front_ieq", x1 - x[i]);
+                report("Boundary_Object_" + id + "_Front_ieqq", x[i] - x2);
+                break;
+            case BACK:
+                report("Boundary_Object_" + id + "_Back_eq", std::abs(y[i] - w[i] / 2 - y1));
+                report("Boundary_Object_" + id + "_Back_ieq", x1 - x[i]);
+                report("Boundary_Object_" + id + "_Back_ieqq", x[i] - x2);
+                break;
+            default: break;
+            }
+        }
+
+        // The matching box corner has to sit on one of the room corners of that kind
+        const std::vector<int>* corners = nullptr;
+        double cx = x[i], cy = y[i];
+        const char* name = "";
+        switch (vp.corner) {
+        case BOTTOMLEFT: corners = &boundary.BLcorner; cx -= l[i] / 2; cy -= w[i] / 2; name = "BottomLeft"; break;
+        case BOTTOMRIGHT: corners = &boundary.BRcorner; cx += l[i] / 2; cy -= w[i] / 2; name = "BottomRight"; break;
+        case TOPLEFT: corners = &boundary.TLcorner; cx -= l[i] / 2; cy += w[i] / 2; name = "TopLeft"; break;
+        case TOPRIGHT: corners = &boundary.TRcorner; cx += l[i] / 2; cy += w[i] / 2; name = "TopRight"; break;
+        default: break;
+        }
+        if (!corners || std::isnan(cx))
+            continue;
+        double distance = std::numeric_limits<double>::infinity();
+        for (int c : *corners)
+            distance = std::min(distance, std::max(std::abs(cx - boundary.points[c][0]), std::abs(cy - boundary.points[c][1])));
+        report(std::string(name) + "_Corner_of_Object_" + id, distance);
+    }
+}
+
+void LayoutVerifier::checkOverlap()
+{
+    // Boxes sorted by their low x; a box only meets the ones whose low x starts before its high x
+    std::vector<size_t> order;
+    for (size_t i = 0; i < x.size(); ++i) {
+        if (!std::isnan(x[i]))
+            order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return x[a] - l[a] / 2 < x[b] - l[b] / 2; });
+    size_t n = order.size();
+    std::vector<double> x0(n), x1(n), y0(n), y1(n), z0(n), z1(n);
+    for (size_t k = 0; k < n; ++k) {
+        size_t i = order[k];
+        x0[k] = x[i] - l[i] / 2; x1[k] = x[i] + l[i] / 2;
+        y0[k] = y[i] - w[i] / 2; y1[k] = y[i] + w[i] / 2;
+        z0[k] = z[i] - h[i] / 2; z1[k] = z[i] + h[i] / 2;
+    }
+    std::vector<double> depth;
+    for (size_t a = 0; a < n; ++a) {
+        size_t end = a + 1;
+        while (end < n && x0[end] < x1[a] - tolerance)
+            ++end;
+        // Penetration depth of a with every candidate, the smallest overlap over the three axes
+        depth.resize(end - a - 1);
+        for (size_t b = a + 1; b < end; ++b) {
+            double dx = std::min(x1[a], x1[b]) - x0[b];
+            double dy = std::min(y1[a], y1[b]) - std::max(y0[a], y0[b]);
+            double dz = std::min(z1[a], z1[b]) - std::max(z0[a], z0[b]);
+            depth[b - a - 1] = std::min(dx, std::min(dy, dz));
+        }
+        for (size_t b = a + 1; b < end; ++b) {
+            if (depth[b - a - 1] > tolerance) {
+                int i = ids[order[a]], j = ids[order[b]];
+                report("NonOverlap_Object_" + std::to_string(std::min(i, j)) + "and_Object_" + std::to_string(std::max(i, j)), depth[b - a - 1]);
+            }
+        }
+    }
+}
+
+std::vector<Violation> LayoutVerifier::verify(const SceneGraph& g, const Boundary& boundary)
+{
+    violations.clear();
+    load(g);
+    checkObjects(g, boundary);
+    checkRelations(g);
+    checkWallsAndCorners(g, boundary);
+    checkOverlap();
+    std::sort(violations.begin(), violations.end(), [](const Violation& a, const Violation& b) { return a.magnitude > b.magnitude; });
+    return violations;
+}
+
+nlohmann::json LayoutVerifier::toJson(const std::vector<Violation>& violations)
+{
+    nlohmann::json j = nlohmann::json::array();
+    for (const auto& v : violations)
+        j.push_back({ {"constraint", v.constraint}, {"magnitude", v.magnitude} });
+    return j;
+}
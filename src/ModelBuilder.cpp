@@ -0,0 +1,48 @@
+#include "ModelBuilder.h"
+#include <algorithm>
+#include <thread>
+
+template <class Terms>
+static void addRow(RowBuffer& rows, const Terms& terms, char sense, double rhs, std::string& name) {
+    for (const auto& t : terms) {
+        rows.vars.push_back(t.first);
+        rows.coeffs.push_back(t.second);
+    }
+    rows.starts.push_back(rows.vars.size());
+    rows.senses.push_back(sense);
+    rows.rhs.push_back(rhs);
+    rows.names.push_back(std::move(name));
+}
+
+void RowBuffer::add(std::initializer_list<std::pair<int, double>> terms, char sense, double rhs, std::string name) {
+    addRow(*this, terms, sense, rhs, name);
+}
+
+void RowBuffer::add(const std::vector<std::pair<int, double>>& terms, char sense, double rhs, std::string name) {
+    addRow(*this, terms, sense, rhs, name);
+}
+
+ModelBuilder::ModelBuilder(int jobs) : jobs(jobs) {
+    if (this->jobs <= 0)
+        this->jobs = std::max(1u, std::thread::hardware_concurrency());
+}
+
+size_t ModelBuilder::chunks(size_t count, size_t min_chunk) const {
+    size_t n = std::min(static_cast<size_t>(jobs), count / std::max<size_t>(min_chunk, 1));
+    return std::max<size_t>(n, 1);
+}
+
+size_t ModelBuilder::forEachChunk(size_t count, size_t min_chunk, const std::function<void(size_t, size_t, size_t)>& fn) const {
+    size_t n = chunks(count, min_chunk);
+    if (n == 1) {
+        fn(0, 0, count);
+        return 1;
+    }
+    std::vector<std::thread> threads;
+    for (size_t c = 1; c < n; ++c)
+        threads.emplace_back(fn, c, count * c / n, count * (c + 1) / n);
+    fn(0, 0, count / n);
+    for (auto& t : threads)
+        t.join();
+    return n;
+}
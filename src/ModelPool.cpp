@@ -0,0 +1,22 @@
+#include "ModelPool.h"
+
+ModelPool::ModelPool(GRBEnv& env, size_t spares) : env(env), max_spares(spares) {}
+
+std::unique_ptr<GRBModel> ModelPool::acquire() {
+    std::unique_ptr<GRBModel> model;
+    if (!spares.empty()) {
+        model = std::move(spares.back());
+        spares.pop_back();
+    }
+    else {
+        model = std::make_unique<GRBModel>(env);
+    }
+    if (preset)
+        preset(*model);
+    return model;
+}
+
+void ModelPool::release(std::unique_ptr<GRBModel> model, bool unused) {
+    if (unused && model && spares.size() < max_spares)
+        spares.push_back(std::move(model));
+}
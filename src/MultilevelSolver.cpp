@@ -0,0 +1,464 @@
+#include "MultilevelSolver.h"
+
+#include "IncrementalCycleDetector.h"
+#include "LayoutVerifier.h"
+#include "SceneReader.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <set>
+#include <thread>
+
+namespace {
+
+bool anchored(const VertexProperties& vp) {
+    return vp.boundary >= 0 || (vp.corner >= TOPLEFT && vp.corner <= BOTTOMRIGHT);
+}
+
+// Objects resting on another one share its footprint, as in the area term of the objective
+bool restsOnOther(const SceneGraph& g, VertexDescriptor v) {
+    for (const auto& e : boost::make_iterator_range(boost::out_edges(v, g))) {
+        if (g[e].type == Above || g[e].type == Under)
+            return true;
+    }
+    return false;
+}
+
+// Violation count first, total magnitude second
+std::pair<size_t, double> score(const std::vector<Violation>& violations) {
+    double total = 0;
+    for (const auto& v : violations)
+        total += std::isfinite(v.magnitude) ? v.magnitude : 1e9;
+    return { violations.size(), total };
+}
+
+}
+
+MultilevelSolver::MultilevelSolver(const MultilevelParams& params, const std::function<void(Solver&)>& configure)
+    : params(params), configure(configure) {}
+
+std::vector<std::vector<VertexDescriptor>> MultilevelSolver::cluster(const SceneGraph& g) const
+{
+    size_t n = boost::num_vertices(g);
+    std::vector<size_t> parent(n), count(n, 1);
+    // Wall and corner of the cluster's anchored objects: the frame takes them over, so a cluster never holds
+    // objects anchored to different walls or corners
+    std::vector<std::optional<std::pair<int, int>>> anchor(n);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (size_t v = 0; v < n; ++v) {
+        if (anchored(g[v]))
+            anchor[v] = std::make_pair(g[v].boundary, static_cast<int>(g[v].corner));
+    }
+    auto find = [&parent](size_t v) {
+        while (parent[v] != v)
+            v = parent[v] = parent[parent[v]];
+        return v;
+    };
+    // Clusters stay within the size cap and hold at most one wall/corner object, unless the relation
+    // must not be cut: Above stacks and alignments are only exact inside one cluster. Even those are cut between
+    // objects on different walls or corners; the verifier then decides whether the layout is kept.
+    auto unite = [&](size_t a, size_t b, bool force) {
+        a = find(a);
+        b = find(b);
+        if (a == b)
+            return;
+        if (anchor[a] && anchor[b] && (!force || *anchor[a] != *anchor[b]))
+            return;
+        if (!force && count[a] + count[b] > static_cast<size_t>(params.max_cluster_size))
+            return;
+        parent[b] = a;
+        count[a] += count[b];
+        if (!anchor[a])
+            anchor[a] = anchor[b];
+    };
+
+    EdgeIterator ei, ei_end;
+    for (EdgeType pass : { Above, CloseBy, LeftOf }) {
+        for (boost::tie(ei, ei_end) = boost::edges(g); ei != ei_end; ++ei) {
+            EdgeType type = g[*ei].type;
+            bool match = pass == Above ? (type == Above || type == Under || type == AlignWith)
+                : pass == CloseBy ? type == CloseBy
+                : (type == LeftOf || type == RightOf || type == FrontOf || type == Behind);
+            if (match)
+                unite(boost::source(*ei, g), boost::target(*ei, g), pass == Above);
+        }
+    }
+
+    // Pack the remaining small clusters with their neighbours in a serpentine order of target positions, so
+    // unrelated objects that want to be close end up in the same frame
+    std::map<size_t, std::vector<VertexDescriptor>> groups;
+    for (size_t v = 0; v < n; ++v)
+        groups[find(v)].push_back(v);
+    struct Key { double strip, x; size_t root; };
+    std::vector<Key> keys;
+    double strips = std::max(1.0, std::floor(std::sqrt(static_cast<double>(groups.size()))));
+    double ymin = 1e300, ymax = -1e300;
+    for (const auto& [root, members] : groups) {
+        for (auto v : members) {
+            if (g[v].target_pos.size() >= 2) {
+                ymin = std::min(ymin, g[v].target_pos[1]);
+                ymax = std::max(ymax, g[v].target_pos[1]);
+            }
+        }
+    }
+    for (const auto& [root, members] : groups) {
+        double x = 0, y = 0;
+        int targets = 0;
+        for (auto v : members) {
+            if (g[v].target_pos.size() >= 2) {
+                x += g[v].target_pos[0];
+                y += g[v].target_pos[1];
+                targets++;
+            }
+        }
+        if (targets == 0) {
+            // Clusters without any target go last, in id order
+            keys.push_back({ strips + 1, static_cast<double>(members.front()), root });
+            continue;
+        }
+        x /= targets;
+        y /= targets;
+        double strip = ymax > ymin ? std::min(strips - 1, std::floor((y - ymin) / (ymax - ymin) * strips)) : 0;
+        keys.push_back({ strip, static_cast<int>(strip) % 2 ? -x : x, root });
+    }
+    std::sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) { return a.strip != b.strip ? a.strip < b.strip : a.x < b.x; });
+    for (size_t k = 1; k < keys.size(); ++k)
+        unite(keys[k - 1].root, keys[k].root, false);
+
+    std::map<size_t, std::vector<VertexDescriptor>> clusters;
+    for (size_t v = 0; v < n; ++v)
+        clusters[find(v)].push_back(v);
+    std::vector<std::vector<VertexDescriptor>> result;
+    for (auto& [root, members] : clusters)
+        result.push_back(std::move(members));
+    return result;
+}
+
+bool MultilevelSolver::solveScene(const SceneGraph& scene, const Boundary& boundary, bool nested, Coordinates& pos, Coordinates& size)
+{
+    Solver child;
+    configure(child);
+    if (!nested)
+        child.multilevel.threshold = 0;
+    child.loadScene(scene, boundary);
+    child.solve();
+    if (!child.hasLayout())
+        return false;
+    const SceneGraph& out = child.solvedGraph();
+    size_t n = boost::num_vertices(out);
+    pos.resize(n);
+    size.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        pos[i] = out[boost::vertex(i, out)].pos;
+        size[i] = out[boost::vertex(i, out)].size;
+    }
+    return true;
+}
+
+bool MultilevelSolver::solveCoarse(const SceneGraph& g, const Boundary& boundary, const std::vector<std::vector<VertexDescriptor>>& clusters,
+    std::vector<Frame>& frames)
+{
+    size_t n = boost::num_vertices(g);
+    double room_l = boundary.size[0], room_w = boundary.size[1], room_h = boundary.size[2];
+    // Objects without a target size are assumed to take half of an even share of the floor
+    double default_side = 0.5 * std::sqrt(room_l * room_w / n);
+    std::vector<int> cluster_of(n);
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        for (auto v : clusters[c])
+            cluster_of[v] = static_cast<int>(c);
+    }
+
+    // The first attempt keeps every frame at least as large as its largest object; the second frees the sizes
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        SceneGraph coarse;
+        for (size_t c = 0; c < clusters.size(); ++c) {
+            double area = 0, max_l = 0, max_w = 0, x = 0, y = 0;
+            int targets = 0;
+            VertexProperties vp{};
+            vp.id = static_cast<int>(c);
+            vp.label = "cluster_" + std::to_string(c);
+            vp.boundary = -1;
+            vp.corner = static_cast<CornerType>(-1);
+            vp.orientation = UP;
+            vp.on_floor = true;
+            vp.hanging = false;
+            for (auto v : clusters[c]) {
+                const VertexProperties& member = g[v];
+                double l = member.target_size.size() >= 2 ? member.target_size[0] : default_side;
+                double w = member.target_size.size() >= 2 ? member.target_size[1] : default_side;
+                max_l = std::max(max_l, l);
+                max_w = std::max(max_w, w);
+                if (!restsOnOther(g, v))
+                    area += l * w;
+                if (member.target_pos.size() >= 2) {
+                    x += member.target_pos[0];
+                    y += member.target_pos[1];
+                    targets++;
+                }
+                // The frame takes the wall or corner of its anchored object
+                if (anchored(member) && vp.boundary < 0 && !(vp.corner >= TOPLEFT && vp.corner <= BOTTOMRIGHT)) {
+                    vp.boundary = member.boundary;
+                    vp.corner = member.corner;
+                }
+            }
+            double l = std::max(max_l, std::sqrt(area * params.slack));
+            double w = std::max(max_w, area * params.slack / l);
+            double lo_l = attempt == 0 ? std::min(max_l, room_l) : 0, hi_l = std::min(room_l, std::max(lo_l, 1.5 * l));
+            double lo_w = attempt == 0 ? std::min(max_w, room_w) : 0, hi_w = std::min(room_w, std::max(lo_w, 1.5 * w));
+            vp.target_size = { (lo_l + hi_l) / 2, (lo_w + hi_w) / 2, room_h };
+            vp.size_tolerance = { (hi_l - lo_l) / 2, (hi_w - lo_w) / 2, 0 };
+            if (targets > 0)
+                vp.target_pos = { x / targets, y / targets, boundary.origin_pos[2] + room_h / 2 };
+            boost::add_vertex(vp, coarse);
+        }
+
+        // Relations between clusters become relations between their frames; the first direction seen wins
+        // when two clusters are ordered both ways
+        IncrementalCycleDetector detector;
+        detector.reset(coarse);
+        std::set<std::tuple<int, int, int>> added;
+        EdgeIterator ei, ei_end;
+        for (boost::tie(ei, ei_end) = boost::edges(g); ei != ei_end; ++ei) {
+            int a = cluster_of[boost::source(*ei, g)], b = cluster_of[boost::target(*ei, g)];
+            EdgeType type = g[*ei].type;
+            if (a == b || (type != LeftOf && type != FrontOf && type != CloseBy))
+                continue;
+            if (type == CloseBy && a > b)
+                std::swap(a, b);
+            if (!added.insert({ a, b, type }).second)
+                continue;
+            std::vector<VertexDescriptor> cycle;
+            if (!detector.insertEdge(boost::vertex(a, coarse), boost::vertex(b, coarse), type, cycle))
+                continue;
+            EdgeProperties ep{};
+            ep.type = type;
+            ep.distance = type == CloseBy ? -1 : 0;
+            ep.align_edge = -1;
+            boost::add_edge(boost::vertex(a, coarse), boost::vertex(b, coarse), ep, coarse);
+        }
+
+        Coordinates pos, size;
+        std::cout << "Multilevel: solving " << clusters.size() << " cluster frames" << std::endl;
+        if (solveScene(coarse, boundary, true, pos, size)) {
+            frames.resize(clusters.size());
+            for (size_t c = 0; c < clusters.size(); ++c)
+                frames[c] = { pos[c][0] - size[c][0] / 2, pos[c][1] - size[c][1] / 2, pos[c][0] + size[c][0] / 2, pos[c][1] + size[c][1] / 2 };
+            return true;
+        }
+    }
+    return false;
+}
+
+Boundary MultilevelSolver::frameBoundary(const Frame& frame, const Boundary& boundary) const
+{
+    // Counter-clockwise like the room, so the sides are back, right, front, left in that order
+    Boundary b;
+    b.origin_pos = { frame.x0, frame.y0, boundary.origin_pos[2] };
+    b.size = { frame.x1 - frame.x0, frame.y1 - frame.y0, boundary.size[2] };
+    b.points = { { frame.x0, frame.y0 }, { frame.x1, frame.y0 }, { frame.x1, frame.y1 }, { frame.x0, frame.y1 } };
+    computeBoundaryGeometry(b);
+    return b;
+}
+
+SceneGraph MultilevelSolver::subScene(const SceneGraph& g, const Boundary& boundary, const std::vector<VertexDescriptor>& free,
+    const std::vector<VertexDescriptor>& fixed, const Frame& frame, bool relaxed) const
+{
+    SceneGraph scene;
+    std::map<VertexDescriptor, VertexDescriptor> index;
+    for (auto v : free) {
+        VertexProperties vp = g[v];
+        vp.id = static_cast<int>(index.size());
+        // A room wall maps to the frame side with the same orientation
+        if (vp.boundary >= 0 && static_cast<size_t>(vp.boundary) < boundary.Orientations.size()) {
+            switch (boundary.Orientations[vp.boundary]) {
+            case BACK: vp.boundary = 0; break;
+            case RIGHT: vp.boundary = 1; break;
+            case FRONT: vp.boundary = 2; break;
+            case LEFT: vp.boundary = 3; break;
+            default: vp.boundary = -1; break;
+            }
+        }
+        // Position tolerances that miss the frame would make the cluster infeasible; the target stays in the objective
+        if (!vp.pos_tolerance.empty() && vp.target_pos.size() >= 2) {
+            bool reachable = vp.target_pos[0] + vp.pos_tolerance[0] > frame.x0 && vp.target_pos[0] - vp.pos_tolerance[0] < frame.x1 &&
+                vp.target_pos[1] + vp.pos_tolerance[1] > frame.y0 && vp.target_pos[1] - vp.pos_tolerance[1] < frame.y1;
+            if (!reachable || relaxed)
+                vp.pos_tolerance.clear();
+        }
+        if (relaxed)
+            vp.size_tolerance.clear();
+        vp.pos.clear();
+        vp.size.clear();
+        index[v] = boost::add_vertex(vp, scene);
+    }
+    for (auto v : fixed) {
+        VertexProperties vp = g[v];
+        vp.id = static_cast<int>(index.size());
+        vp.boundary = -1;
+        vp.corner = static_cast<CornerType>(-1);
+        vp.target_pos = vp.pos;
+        vp.target_size = vp.size;
+        vp.pos_tolerance = { 0, 0, 0 };
+        vp.size_tolerance = { 0, 0, 0 };
+        vp.pos.clear();
+        vp.size.clear();
+        index[v] = boost::add_vertex(vp, scene);
+    }
+    std::set<VertexDescriptor> free_set(free.begin(), free.end());
+    EdgeIterator ei, ei_end;
+    for (boost::tie(ei, ei_end) = boost::edges(g); ei != ei_end; ++ei) {
+        VertexDescriptor s = boost::source(*ei, g), t = boost::target(*ei, g);
+        if (!index.count(s) || !index.count(t) || (!free_set.count(s) && !free_set.count(t)))
+            continue;
+        EdgeProperties ep = g[*ei];
+        ep.implied = false;
+        boost::add_edge(index[s], index[t], ep, scene);
+    }
+    return scene;
+}
+
+bool MultilevelSolver::refine(const SceneGraph& g, const Boundary& boundary, const std::vector<VertexDescriptor>& members, const Frame& frame,
+    Coordinates& pos, Coordinates& size)
+{
+    Boundary frame_boundary = frameBoundary(frame, boundary);
+    for (bool relaxed : { false, true }) {
+        SceneGraph scene = subScene(g, boundary, members, {}, frame, relaxed);
+        if (solveScene(scene, frame_boundary, false, pos, size))
+            return true;
+    }
+    return false;
+}
+
+void MultilevelSolver::polish(SceneGraph& g, const Boundary& boundary, const std::vector<std::vector<VertexDescriptor>>& clusters,
+    const std::vector<Frame>& frames)
+{
+    size_t n = boost::num_vertices(g);
+    std::vector<int> cluster_of(n);
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        for (auto v : clusters[c])
+            cluster_of[v] = static_cast<int>(c);
+    }
+    std::set<std::pair<int, int>> neighbours;
+    EdgeIterator ei, ei_end;
+    for (boost::tie(ei, ei_end) = boost::edges(g); ei != ei_end; ++ei) {
+        int a = cluster_of[boost::source(*ei, g)], b = cluster_of[boost::target(*ei, g)];
+        if (a != b)
+            neighbours.insert({ std::min(a, b), std::max(a, b) });
+    }
+
+    LayoutVerifier verifier;
+    auto current = score(verifier.verify(g, boundary));
+    const double eps = 1e-6;
+    int accepted = 0;
+    for (const auto& [a, b] : neighbours) {
+        Frame window = { std::min(frames[a].x0, frames[b].x0), std::min(frames[a].y0, frames[b].y0),
+            std::max(frames[a].x1, frames[b].x1), std::max(frames[a].y1, frames[b].y1) };
+        std::vector<VertexDescriptor> free = clusters[a], fixed;
+        free.insert(free.end(), clusters[b].begin(), clusters[b].end());
+        // A seam whose own objects and relations already hold cannot lower the score, so it is not re-solved
+        SceneGraph seam;
+        std::map<VertexDescriptor, VertexDescriptor> seam_index;
+        for (auto v : free)
+            seam_index[v] = boost::add_vertex(g[v], seam);
+        for (auto v : free) {
+            for (const auto& e : boost::make_iterator_range(boost::out_edges(v, g))) {
+                auto it = seam_index.find(boost::target(e, g));
+                if (it != seam_index.end())
+                    boost::add_edge(seam_index[v], it->second, g[e], seam);
+            }
+        }
+        if (verifier.verify(seam, boundary).empty())
+            continue;
+        // Other objects inside the window stay where they are; one that only partly overlaps it rules the window out
+        bool usable = true;
+        for (size_t v = 0; v < n && usable; ++v) {
+            if (cluster_of[v] == a || cluster_of[v] == b)
+                continue;
+            const VertexProperties& vp = g[v];
+            double x0 = vp.pos[0] - vp.size[0] / 2, x1 = vp.pos[0] + vp.size[0] / 2;
+            double y0 = vp.pos[1] - vp.size[1] / 2, y1 = vp.pos[1] + vp.size[1] / 2;
+            bool outside = x1 <= window.x0 + eps || x0 >= window.x1 - eps || y1 <= window.y0 + eps || y0 >= window.y1 - eps;
+            bool inside = x0 >= window.x0 - eps && x1 <= window.x1 + eps && y0 >= window.y0 - eps && y1 <= window.y1 + eps;
+            if (inside)
+                fixed.push_back(v);
+            else if (!outside)
+                usable = false;
+        }
+        if (!usable || static_cast<int>(free.size() + fixed.size()) > std::max(params.threshold, 2 * params.max_cluster_size))
+            continue;
+
+        SceneGraph scene = subScene(g, boundary, free, fixed, window, false);
+        Coordinates pos, size;
+        if (!solveScene(scene, frameBoundary(window, boundary), false, pos, size))
+            continue;
+        // Keep the new placement only if the whole layout does not get worse
+        Coordinates old_pos, old_size;
+        for (size_t k = 0; k < free.size(); ++k) {
+            old_pos.push_back(g[free[k]].pos);
+            old_size.push_back(g[free[k]].size);
+            g[free[k]].pos = pos[k];
+            g[free[k]].size = size[k];
+        }
+        auto polished = score(verifier.verify(g, boundary));
+        if (polished <= current) {
+            current = polished;
+            accepted++;
+        }
+        else {
+            for (size_t k = 0; k < free.size(); ++k) {
+                g[free[k]].pos = old_pos[k];
+                g[free[k]].size = old_size[k];
+            }
+        }
+    }
+    std::cout << "Multilevel: polished " << accepted << " of " << neighbours.size() << " cluster seams" << std::endl;
+}
+
+bool MultilevelSolver::solve(SceneGraph& g, const Boundary& boundary)
+{
+    size_t n = boost::num_vertices(g);
+    auto clusters = cluster(g);
+    if (clusters.size() <= 1 || clusters.size() >= n) {
+        std::cout << "Multilevel: clustering does not shrink the scene" << std::endl;
+        return false;
+    }
+    std::vector<Frame> frames;
+    if (!solveCoarse(g, boundary, clusters, frames)) {
+        std::cout << "Multilevel: no layout for the cluster frames" << std::endl;
+        return false;
+    }
+
+    // Frames are fixed, so clusters are independent and refined on params.jobs threads
+    std::vector<Coordinates> pos(clusters.size()), size(clusters.size());
+    std::vector<char> solved(clusters.size(), 0);
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&]() {
+        for (size_t c = next++; c < clusters.size(); c = next++)
+            solved[c] = refine(g, boundary, clusters[c], frames[c], pos[c], size[c]);
+    };
+    std::vector<std::thread> threads;
+    for (int k = 1; k < params.jobs; ++k)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads)
+        t.join();
+
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        if (!solved[c]) {
+            std::cout << "Multilevel: no layout for cluster " << c << std::endl;
+            return false;
+        }
+    }
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        for (size_t k = 0; k < clusters[c].size(); ++k) {
+            g[clusters[c][k]].pos = pos[c][k];
+            g[clusters[c][k]].size = size[c][k];
+        }
+    }
+    if (params.polish)
+        polish(g, boundary, clusters, frames);
+    return true;
+}
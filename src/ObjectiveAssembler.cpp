@@ -0,0 +1,102 @@
+#include "ObjectiveAssembler.h"
+#include <algorithm>
+
+void ObjectiveAssembler::addConstant(double c) {
+    constant += c;
+}
+
+void ObjectiveAssembler::addLinear(int var, double coeff) {
+    linear.push_back({ var, coeff });
+    merged = false;
+}
+
+void ObjectiveAssembler::addQuadratic(int a, int b, double coeff) {
+    if (a > b)
+        std::swap(a, b);
+    quadratic.push_back({ a, b, coeff });
+    merged = false;
+}
+
+void ObjectiveAssembler::addSquare(std::initializer_list<Term> terms, double constant, double coeff) {
+    // (sum c_k v_k + d)^2 = sum_k c_k^2 v_k^2 + sum_{k<m} 2 c_k c_m v_k v_m + sum_k 2 d c_k v_k + d^2
+    for (auto k = terms.begin(); k != terms.end(); ++k) {
+        addQuadratic(k->first, k->first, coeff * k->second * k->second);
+        for (auto m = k + 1; m != terms.end(); ++m)
+            addQuadratic(k->first, m->first, 2 * coeff * k->second * m->second);
+        if (constant != 0)
+            addLinear(k->first, 2 * coeff * constant * k->second);
+    }
+    addConstant(coeff * constant * constant);
+}
+
+void ObjectiveAssembler::add(const ObjectiveAssembler& other, double weight) {
+    if (weight == 0)
+        return;
+    constant += weight * other.constant;
+    for (const auto& q : other.quadratic)
+        quadratic.push_back({ q.a, q.b, weight * q.coeff });
+    for (const auto& t : other.linear)
+        linear.push_back({ t.first, weight * t.second });
+    merged = merged && other.quadratic.empty() && other.linear.empty();
+}
+
+void ObjectiveAssembler::scale(double factor) {
+    constant *= factor;
+    for (auto& q : quadratic)
+        q.coeff *= factor;
+    for (auto& t : linear)
+        t.second *= factor;
+}
+
+void ObjectiveAssembler::clear() {
+    constant = 0;
+    quadratic.clear();
+    linear.clear();
+    merged = true;
+}
+
+void ObjectiveAssembler::merge() {
+    if (merged)
+        return;
+    std::sort(quadratic.begin(), quadratic.end(), [](const QuadEntry& p, const QuadEntry& q) {
+        return p.a != q.a ? p.a < q.a : p.b < q.b;
+    });
+    size_t n = 0;
+    for (size_t k = 0; k < quadratic.size(); ++k) {
+        if (n > 0 && quadratic[n - 1].a == quadratic[k].a && quadratic[n - 1].b == quadratic[k].b)
+            quadratic[n - 1].coeff += quadratic[k].coeff;
+        else
+            quadratic[n++] = quadratic[k];
+    }
+    quadratic.resize(n);
+    // Cross terms of a difference cancel, e.g. the x_s*x_t parts of two mirrored edges
+    quadratic.erase(std::remove_if(quadratic.begin(), quadratic.end(), [](const QuadEntry& q) { return q.coeff == 0; }),
+        quadratic.end());
+
+    std::sort(linear.begin(), linear.end(), [](const Term& p, const Term& q) { return p.first < q.first; });
+    n = 0;
+    for (size_t k = 0; k < linear.size(); ++k) {
+        if (n > 0 && linear[n - 1].first == linear[k].first)
+            linear[n - 1].second += linear[k].second;
+        else
+            linear[n++] = linear[k];
+    }
+    linear.resize(n);
+    linear.erase(std::remove_if(linear.begin(), linear.end(), [](const Term& t) { return t.second == 0; }), linear.end());
+    merged = true;
+}
+
+size_t ObjectiveAssembler::size() {
+    merge();
+    return quadratic.size() + linear.size();
+}
+
+const std::vector<ObjectiveAssembler::QuadEntry>& ObjectiveAssembler::quadraticTerms() {
+    merge();
+    return quadratic;
+}
+
+const std::vector<ObjectiveAssembler::Term>& ObjectiveAssembler::linearTerms() {
+    merge();
+    return linear;
+}
@@ -0,0 +1,54 @@
+#include "Portfolio.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+PortfolioCallback::PortfolioCallback(PortfolioShared& shared, GRBVar* vars, int num_vars, int member)
+	: shared(shared), vars(vars), num_vars(num_vars), member(member) {}
+
+bool PortfolioCallback::gapReached(double bound)
+{
+	// Gap of the shared incumbent against this member's bound, as Gurobi defines MIPGap
+	if (shared.best_obj >= GRB_INFINITY)
+		return false;
+	return std::abs(shared.best_obj - bound) <= shared.target_gap * std::max(std::abs(shared.best_obj), 1e-10);
+}
+
+void PortfolioCallback::callback()
+{
+	try {
+		if (shared.done) {
+			abort();
+			return;
+		}
+		if (where == GRB_CB_MIPSOL) {
+			double obj = getDoubleInfo(GRB_CB_MIPSOL_OBJ);
+			std::lock_guard<std::mutex> lock(shared.mutex);
+			if (obj < shared.best_obj) {
+				double* x = getSolution(vars, num_vars);
+				shared.best_x.assign(x, x + num_vars);
+				delete[] x;
+				shared.best_obj = obj;
+				shared.best_member = member;
+			}
+		}
+		else if (where == GRB_CB_MIPNODE && getIntInfo(GRB_CB_MIPNODE_STATUS) == GRB_OPTIMAL) {
+			// Hand a better incumbent found by another member to this one
+			double own = getDoubleInfo(GRB_CB_MIPNODE_OBJBST);
+			std::lock_guard<std::mutex> lock(shared.mutex);
+			if (!shared.best_x.empty() && shared.best_obj < own - 1e-9)
+				setSolution(vars, shared.best_x.data(), num_vars);
+		}
+		else if (where == GRB_CB_MIP) {
+			double bound = getDoubleInfo(GRB_CB_MIP_OBJBND);
+			std::lock_guard<std::mutex> lock(shared.mutex);
+			if (gapReached(bound)) {
+				shared.done = true;
+				abort();
+			}
+		}
+	}
+	catch (GRBException e) {
+		std::cout << "Error in portfolio callback: " << e.getMessage() << std::endl;
+	}
+}
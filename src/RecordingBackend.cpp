@@ -0,0 +1,136 @@
+#include "RecordingBackend.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+int RecordingBackend::addVars(int count, const double* lb, const double* ub, const char* types, const std::string* names) {
+    int first = numVars();
+    this->lb.insert(this->lb.end(), lb, lb + count);
+    this->ub.insert(this->ub.end(), ub, ub + count);
+    this->types.insert(this->types.end(), types, types + count);
+    this->names.insert(this->names.end(), names, names + count);
+    return first;
+}
+
+void RecordingBackend::addRows(const RowBuffer& buffer) {
+    size_t offset = rows.vars.size();
+    rows.vars.insert(rows.vars.end(), buffer.vars.begin(), buffer.vars.end());
+    rows.coeffs.insert(rows.coeffs.end(), buffer.coeffs.begin(), buffer.coeffs.end());
+    for (size_t k = 1; k < buffer.starts.size(); ++k)
+        rows.starts.push_back(offset + buffer.starts[k]);
+    rows.senses.insert(rows.senses.end(), buffer.senses.begin(), buffer.senses.end());
+    rows.rhs.insert(rows.rhs.end(), buffer.rhs.begin(), buffer.rhs.end());
+    rows.names.insert(rows.names.end(), buffer.names.begin(), buffer.names.end());
+}
+
+void RecordingBackend::setObjective(ObjectiveAssembler& objective) {
+    quadratic = objective.quadraticTerms();
+    linear = objective.linearTerms();
+    constant = objective.constantTerm();
+}
+
+bool RecordingBackend::optimize() {
+    solution.clear();
+    if (stored.empty())
+        return false;
+    std::vector<double> values(numVars());
+    for (int v = 0; v < numVars(); ++v) {
+        auto it = stored.find(varName(v));
+        if (it == stored.end())
+            return false;
+        values[v] = it->second;
+    }
+    solution = values;
+    objective_value = constant;
+    for (const auto& q : quadratic)
+        objective_value += q.coeff * solution[q.a] * solution[q.b];
+    for (const auto& t : linear)
+        objective_value += t.second * solution[t.first];
+    return true;
+}
+
+double RecordingBackend::value(int var) const {
+    return solution[var];
+}
+
+int RecordingBackend::numBinaries() const {
+    return static_cast<int>(std::count(types.begin(), types.end(), kBinary));
+}
+
+int RecordingBackend::numEqualities() const {
+    return static_cast<int>(std::count(rows.senses.begin(), rows.senses.end(), kEqual));
+}
+
+bool RecordingBackend::loadSolution(const std::string& path, std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+    stored.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string name;
+        double value;
+        if (fields >> name >> value)
+            stored[name] = value;
+    }
+    if (stored.empty()) {
+        error = path + " holds no values";
+        return false;
+    }
+    return true;
+}
+
+std::string RecordingBackend::varName(int var) const {
+    return names[var].empty() ? "C" + std::to_string(var) : names[var];
+}
+
+// Writes " + c name" / " - c name" with the coefficient omitted when it is 1
+static void writeTerm(std::ostream& out, double coeff, const std::string& name) {
+    out << (coeff < 0 ? " - " : " + ");
+    if (std::abs(coeff) != 1)
+        out << std::abs(coeff) << " ";
+    out << name;
+}
+
+void RecordingBackend::writeLP(std::ostream& out) const {
+    out.precision(17);
+    out << "\\ Recorded layout model: " << numVars() << " variables, " << numRows() << " rows" << std::endl;
+    out << "Minimize" << std::endl << "  obj:";
+    for (const auto& t : linear)
+        writeTerm(out, t.second, varName(t.first));
+    if (!quadratic.empty()) {
+        // LP format divides the bracket by 2
+        out << " + [";
+        for (const auto& q : quadratic)
+            writeTerm(out, 2 * q.coeff, q.a == q.b ? varName(q.a) + " ^ 2" : varName(q.a) + " * " + varName(q.b));
+        out << " ] / 2";
+    }
+    if (constant != 0)
+        out << (constant < 0 ? " - " : " + ") << std::abs(constant);
+    out << std::endl << "Subject To" << std::endl;
+    for (int k = 0; k < numRows(); ++k) {
+        out << "  " << (rows.names[k].empty() ? "R" + std::to_string(k) : rows.names[k]) << ":";
+        for (size_t t = rows.starts[k]; t < rows.starts[k + 1]; ++t)
+            writeTerm(out, rows.coeffs[t], varName(rows.vars[t]));
+        out << " " << (rows.senses[k] == kEqual ? "=" : rows.senses[k] == kLessEqual ? "<=" : ">=") << " " << rows.rhs[k]
+            << std::endl;
+    }
+    out << "Bounds" << std::endl;
+    for (int v = 0; v < numVars(); ++v) {
+        if (types[v] != kBinary)
+            out << "  " << lb[v] << " <= " << varName(v) << " <= " << ub[v] << std::endl;
+        else if (ub[v] == 0)
+            out << "  " << varName(v) << " = 0" << std::endl;
+    }
+    out << "Binaries" << std::endl;
+    for (int v = 0; v < numVars(); ++v) {
+        if (types[v] == kBinary)
+            out << "  " << varName(v) << std::endl;
+    }
+    out << "End" << std::endl;
+}
@@ -0,0 +1,620 @@
+#include "SceneReader.h"
+
+#include <cstring>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <tuple>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+void applyVertexDefaults(VertexProperties& vp)
+{
+    if (vp.target_size.empty())
+        vp.size_tolerance.clear();
+    else if (vp.size_tolerance.empty()) {
+        vp.size_tolerance = { vp.target_size[0] * 0.1, vp.target_size[1] * 0.1, vp.on_floor ? 0 : vp.target_size[2] * 0.1 };
+    }
+    if (vp.target_pos.empty())
+        vp.pos_tolerance.clear();
+    else if (vp.pos_tolerance.empty() && !vp.target_size.empty()) {
+        vp.pos_tolerance = { vp.target_size[0] * 0.1, vp.target_size[1] * 0.1, vp.on_floor ? 0 : vp.target_size[2] * 0.1 };
+    }
+}
+
+void applyEdgeDefaults(EdgeProperties& ep)
+{
+    if (ep.type == AlignWith) {
+        ep.distance = -1;
+        ep.xyoffset.clear();
+    }
+    else if (ep.type == CloseBy) {
+        ep.distance = -1;
+        ep.align_edge = -1;
+    }
+    else if (ep.type == Above || ep.type == Under) {
+        ep.align_edge = -1;
+    }
+    else {
+        ep.align_edge = -1;
+        ep.xyoffset.clear();
+    }
+}
+
+void computeBoundaryGeometry(Boundary& boundary)
+{
+	boundary.BLcorner.clear();
+	boundary.BRcorner.clear();
+	boundary.TLcorner.clear();
+	boundary.TRcorner.clear();
+	// calculate orientations
+    boundary.Orientations = std::vector<Orientation>(boundary.points.size(), FRONT);
+	
+	for (std::size_t i = 0; i < boundary.points.size(); ++i) {
+        // Get the current edge
+        std::vector<double> p1 = boundary.points[i];
+        std::vector<double> p2 = boundary.points[(i + 1) % boundary.points.size()];
+
+        // Calculate direction vector
+        std::vector<double> direction = {p2[0] - p1[0], p2[1] - p1[1]};
+
+        // Determine normal vector (rotate direction by 90 degrees)
+        std::vector<double> normal = {direction[1], -direction[0]};
+
+        // Determine orientation
+        if (normal[0] > 0) {
+            boundary.Orientations[i] = RIGHT;
+        } else if (normal[0] < 0) {
+            boundary.Orientations[i] = LEFT;
+        } else if (normal[1] > 0) {
+            boundary.Orientations[i] = FRONT;
+        } else {
+            boundary.Orientations[i] = BACK;
+        }
+    }
+	for (std::size_t i = 0; i < boundary.Orientations.size(); ++i) {
+		Orientation o1 = boundary.Orientations[i];
+		Orientation o2 = boundary.Orientations[(i + 1) % boundary.Orientations.size()];
+		if (o1 == LEFT && o2 == BACK)
+			boundary.BLcorner.push_back((i + 1) % boundary.Orientations.size());
+		else if (o1 == BACK && o2 == RIGHT)
+			boundary.BRcorner.push_back((i + 1) % boundary.Orientations.size());
+		else if (o1 == RIGHT && o2 == FRONT)
+			boundary.TRcorner.push_back((i + 1) % boundary.Orientations.size());
+		else if (o1 == FRONT && o2 == LEFT)
+			boundary.TLcorner.push_back((i + 1) % boundary.Orientations.size());
+	}
+}
+
+namespace {
+
+// Value checks shared by the JSON and binary readers; an empty result means the record is usable
+std::string checkBoundary(const Boundary& boundary)
+{
+    if (boundary.origin_pos.size() != 3 || boundary.size.size() != 3)
+        return "boundary origin_pos and size need 3 entries";
+    if (boundary.points.size() < 3)
+        return "boundary needs at least 3 points";
+    for (const auto& point : boundary.points)
+        if (point.size() < 2)
+            return "boundary points need x and y";
+    return "";
+}
+
+std::string checkVertex(const VertexProperties& vp)
+{
+    std::string name = "vertex " + std::to_string(vp.id);
+    if (vp.orientation < UP || vp.orientation > BACK)
+        return name + " has an unknown orientation";
+    if (!vp.target_pos.empty() && vp.target_pos.size() != 3)
+        return name + ": target_pos needs 3 entries";
+    if (!vp.target_size.empty() && vp.target_size.size() != 3)
+        return name + ": target_size needs 3 entries";
+    return "";
+}
+
+std::string checkEdge(int source, int target, const EdgeProperties& ep)
+{
+    if (ep.type < LeftOf || ep.type > AlignWith)
+        return "edge " + std::to_string(source) + " -> " + std::to_string(target) + " has an unknown type";
+    return "";
+}
+
+// Nesting: root object (1) > "boundary" object (2) > origin_pos/size/points array (3) > point array (4),
+// and root object (1) > "vertices"/"edges" array (2) > record object (3) > field array (4).
+class SceneSaxHandler : public nlohmann::json_sax<nlohmann::json> {
+public:
+    SceneSaxHandler(SceneGraph& graph, Boundary& boundary) : graph(graph), boundary(boundary) {}
+
+    bool null() override { return true; }
+    bool boolean(bool val) override {
+        if (section == InVertices && depth == 3) {
+            if (field == "on_floor") { vp.on_floor = val; seen |= kOnFloor; }
+            else if (field == "hanging") { vp.hanging = val; seen |= kHanging; }
+        }
+        return true;
+    }
+    bool number_integer(number_integer_t val) override { return number(static_cast<double>(val)); }
+    bool number_unsigned(number_unsigned_t val) override { return number(static_cast<double>(val)); }
+    bool number_float(number_float_t val, const string_t&) override { return number(val); }
+    bool string(string_t& val) override {
+        if (section == InVertices && depth == 3 && field == "label") {
+            vp.label = std::move(val);
+            seen |= kLabel;
+        }
+        return true;
+    }
+    bool binary(binary_t&) override { return true; }
+
+    bool start_object(std::size_t) override {
+        ++depth;
+        if (depth == 3 && section == InVertices)
+            vp = VertexProperties{};
+        else if (depth == 3 && section == InEdges) {
+            ep = EdgeProperties{};
+            source = target = -1;
+        }
+        if (depth == 3)
+            seen = 0;
+        else if (depth == 2 && section == InBoundary)
+            boundary_seen = 0;
+        return true;
+    }
+    bool end_object() override {
+        if (depth == 3 && section == InVertices) {
+            size_t index = boost::num_vertices(graph);
+            if (!requireFields("vertex " + std::to_string(index), kVertexFields, { "id", "label", "boundary", "corner",
+                "orientation", "on_floor", "hanging", "target_pos", "target_size" }))
+                return false;
+            error = checkVertex(vp);
+            if (!error.empty())
+                return false;
+            applyVertexDefaults(vp);
+            boost::add_vertex(std::move(vp), graph);
+        }
+        else if (depth == 3 && section == InEdges) {
+            if (!requireFields("edge " + std::to_string(edges.size()), kEdgeFields, { "source", "target", "type" }))
+                return false;
+            error = checkEdge(source, target, ep);
+            if (!error.empty())
+                return false;
+            applyEdgeDefaults(ep);
+            edges.emplace_back(source, target, std::move(ep));
+        }
+        else if (depth == 2 && section == InBoundary) {
+            for (const char* name : { "origin_pos", "size", "points" }) {
+                if (!(boundary_seen & boundaryBit(name))) {
+                    error = std::string("boundary misses ") + name;
+                    return false;
+                }
+            }
+        }
+        else if (depth == 1) {
+            finished = true;
+            if (!boundary_read) {
+                error = "scene has no boundary";
+                return false;
+            }
+            error = checkBoundary(boundary);
+            if (!error.empty())
+                return false;
+            // Edges may precede vertices in the file, so they are added once the whole scene is read
+            int n = static_cast<int>(boost::num_vertices(graph));
+            for (auto& [s, t, e] : edges) {
+                if (s < 0 || t < 0 || s >= n || t >= n) {
+                    error = "edge " + std::to_string(s) + " -> " + std::to_string(t) + " references a missing vertex";
+                    return false;
+                }
+                boost::add_edge(boost::vertex(s, graph), boost::vertex(t, graph), std::move(e), graph);
+            }
+            edges.clear();
+        }
+        --depth;
+        return true;
+    }
+    bool start_array(std::size_t) override {
+        ++depth;
+        if (section == InBoundary && depth == 3) {
+            if (field == "origin_pos") array = &boundary.origin_pos;
+            else if (field == "size") array = &boundary.size;
+            boundary_seen |= boundaryBit(field);
+        }
+        else if (section == InBoundary && depth == 4 && field == "points") {
+            boundary.points.emplace_back();
+            array = &boundary.points.back();
+        }
+        else if (section == InVertices && depth == 4) {
+            if (field == "target_pos") { array = &vp.target_pos; seen |= kTargetPos; }
+            else if (field == "target_size") { array = &vp.target_size; seen |= kTargetSize; }
+            else if (field == "pos_tolerance") array = &vp.pos_tolerance;
+            else if (field == "size_tolerance") array = &vp.size_tolerance;
+            // Present in solver output, so output.json can be read back for verification
+            else if (field == "position") array = &vp.pos;
+            else if (field == "size") array = &vp.size;
+        }
+        else if (section == InEdges && depth == 4 && field == "xyoffset")
+            array = &ep.xyoffset;
+        return true;
+    }
+    bool end_array() override {
+        array = nullptr;
+        --depth;
+        return true;
+    }
+    bool key(string_t& val) override {
+        if (depth == 1) {
+            if (val == "boundary") { section = InBoundary; boundary_read = true; }
+            else if (val == "vertices") section = InVertices;
+            else if (val == "edges") section = InEdges;
+            else section = InOther;
+        }
+        else if ((section == InBoundary && depth == 2) || (section != InBoundary && depth == 3))
+            field = std::move(val);
+        return true;
+    }
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+        error = ex.what();
+        return false;
+    }
+
+    std::string error;
+    // Set when the root object has been read in full
+    bool finished = false;
+
+private:
+    enum Section { InNone, InBoundary, InVertices, InEdges, InOther };
+    // Required fields of the current record, in the order of the names passed to requireFields
+    enum Field : unsigned {
+        kId = 1, kLabel = 2, kBoundary = 4, kCorner = 8, kOrientation = 16, kOnFloor = 32, kHanging = 64,
+        kTargetPos = 128, kTargetSize = 256, kVertexFields = 511,
+        kSource = 1, kTarget = 2, kType = 4, kEdgeFields = 7
+    };
+
+    // The DOM reader threw on every missing key; defaults would silently pin objects to wall 0 and corner 0
+    bool requireFields(const std::string& record, unsigned required, std::initializer_list<const char*> names) {
+        if ((seen & required) == required)
+            return true;
+        unsigned bit = 1;
+        for (const char* name : names) {
+            if (!(seen & bit)) {
+                error = record + " misses " + name;
+                break;
+            }
+            bit <<= 1;
+        }
+        return false;
+    }
+    static unsigned boundaryBit(const std::string& name) {
+        return name == "origin_pos" ? 1 : name == "size" ? 2 : name == "points" ? 4 : 0;
+    }
+
+    bool number(double val) {
+        // Only arrays the scene knows get an array pointer; numbers in nested unknown arrays are dropped
+        if (array) {
+            if (depth == 3 || depth == 4)
+                array->push_back(val);
+            return true;
+        }
+        if (depth != 3)
+            return true;
+        if (section == InVertices) {
+            if (field == "id") { vp.id = static_cast<int>(val); seen |= kId; }
+            else if (field == "boundary") { vp.boundary = static_cast<int>(val); seen |= kBoundary; }
+            else if (field == "corner") { vp.corner = static_cast<CornerType>(static_cast<int>(val)); seen |= kCorner; }
+            else if (field == "orientation") { vp.orientation = static_cast<Orientation>(static_cast<int>(val)); seen |= kOrientation; }
+        }
+        else if (section == InEdges) {
+            if (field == "source") { source = static_cast<int>(val); seen |= kSource; }
+            else if (field == "target") { target = static_cast<int>(val); seen |= kTarget; }
+            else if (field == "type") { ep.type = static_cast<EdgeType>(static_cast<int>(val)); seen |= kType; }
+            else if (field == "distance") ep.distance = val;
+            else if (field == "align_edge") ep.align_edge = static_cast<int>(val);
+        }
+        return true;
+    }
+
+    SceneGraph& graph;
+    Boundary& boundary;
+    Section section = InNone;
+    int depth = 0;
+    std::string field;
+    std::vector<double>* array = nullptr;
+    VertexProperties vp{};
+    EdgeProperties ep{};
+    int source = -1, target = -1;
+    unsigned seen = 0, boundary_seen = 0;
+    bool boundary_read = false;
+    std::vector<std::tuple<int, int, EdgeProperties>> edges;
+};
+
+// Read-only view of a whole file, unmapped on destruction
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+            return;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+            return;
+        data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (data)
+            size = static_cast<size_t>(file_size.QuadPart);
+#else
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+            return;
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+            return;
+        data = static_cast<const char*>(p);
+        size = static_cast<size_t>(st.st_size);
+#endif
+    }
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (data) munmap(const_cast<char*>(data), size);
+        if (fd >= 0) close(fd);
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data = nullptr;
+    size_t size = 0;
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+// Bounds-checked cursor over the mapped bytes; any overrun sets ok to false and yields zeros
+struct BinaryCursor {
+    const char* p;
+    const char* end;
+    bool ok = true;
+
+    template <class T>
+    T read() {
+        T val{};
+        if (end - p < static_cast<std::ptrdiff_t>(sizeof(T))) {
+            ok = false;
+            return val;
+        }
+        std::memcpy(&val, p, sizeof(T));
+        p += sizeof(T);
+        return val;
+    }
+    void readVector(std::vector<double>& v) {
+        uint32_t n = read<uint32_t>();
+        if (end - p < static_cast<std::ptrdiff_t>(n * sizeof(double))) {
+            ok = false;
+            return;
+        }
+        v.resize(n);
+        if (n)
+            std::memcpy(v.data(), p, n * sizeof(double));
+        p += n * sizeof(double);
+    }
+    void readString(std::string& s) {
+        uint32_t n = read<uint32_t>();
+        if (end - p < static_cast<std::ptrdiff_t>(n)) {
+            ok = false;
+            return;
+        }
+        s.assign(p, n);
+        p += n;
+    }
+};
+
+class BinaryWriter {
+public:
+    explicit BinaryWriter(std::ofstream& out) : out(out) {}
+    template <class T>
+    void write(T val) { out.write(reinterpret_cast<const char*>(&val), sizeof(T)); }
+    void writeVector(const std::vector<double>& v) {
+        write(static_cast<uint32_t>(v.size()));
+        out.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(double));
+    }
+    void writeString(const std::string& s) {
+        write(static_cast<uint32_t>(s.size()));
+        out.write(s.data(), s.size());
+    }
+private:
+    std::ofstream& out;
+};
+
+}
+
+bool readSceneJson(const char* begin, const char* end, SceneGraph& graph, Boundary& boundary, std::string& error)
+{
+    SceneSaxHandler handler(graph, boundary);
+    bool ok = nlohmann::json::sax_parse(begin, end, &handler);
+    if (!ok)
+        error = handler.error.empty() ? "malformed scene JSON" : handler.error;
+    else if (!handler.finished)
+        error = "scene is not a JSON object";
+    return ok && handler.finished;
+}
+
+bool readSceneBinary(const std::string& path, SceneGraph& graph, Boundary& boundary, std::string& error)
+{
+    MappedFile file(path);
+    if (!file.data) {
+        error = "cannot map " + path;
+        return false;
+    }
+    BinaryCursor in{ file.data, file.data + file.size };
+    char magic[4];
+    for (char& c : magic)
+        c = in.read<char>();
+    if (!in.ok || std::memcmp(magic, kSceneBinaryMagic, 4) != 0) {
+        error = path + " is not a binary scene";
+        return false;
+    }
+    uint32_t version = in.read<uint32_t>();
+    if (version != kSceneBinaryVersion) {
+        error = path + " has binary scene version " + std::to_string(version) + ", expected " + std::to_string(kSceneBinaryVersion);
+        return false;
+    }
+    uint32_t num_vertices = in.read<uint32_t>();
+    uint32_t num_edges = in.read<uint32_t>();
+
+    in.readVector(boundary.origin_pos);
+    in.readVector(boundary.size);
+    uint32_t num_points = in.read<uint32_t>();
+    for (uint32_t i = 0; i < num_points && in.ok; ++i) {
+        boundary.points.emplace_back();
+        in.readVector(boundary.points.back());
+    }
+    // The format has no optional fields, but its values get the same checks as JSON scenes
+    std::string invalid = in.ok ? checkBoundary(boundary) : "";
+
+    for (uint32_t i = 0; i < num_vertices && in.ok; ++i) {
+        VertexProperties vp{};
+        vp.id = in.read<int32_t>();
+        vp.boundary = in.read<int32_t>();
+        vp.corner = static_cast<CornerType>(in.read<int32_t>());
+        vp.orientation = static_cast<Orientation>(in.read<int32_t>());
+        vp.on_floor = in.read<uint8_t>() != 0;
+        vp.hanging = in.read<uint8_t>() != 0;
+        in.readString(vp.label);
+        in.readVector(vp.target_pos);
+        in.readVector(vp.target_size);
+        in.readVector(vp.pos_tolerance);
+        in.readVector(vp.size_tolerance);
+        if (in.ok && invalid.empty())
+            invalid = checkVertex(vp);
+        boost::add_vertex(std::move(vp), graph);
+    }
+
+    for (uint32_t i = 0; i < num_edges && in.ok; ++i) {
+        EdgeProperties ep{};
+        int32_t source = in.read<int32_t>();
+        int32_t target = in.read<int32_t>();
+        ep.type = static_cast<EdgeType>(in.read<int32_t>());
+        ep.align_edge = in.read<int32_t>();
+        ep.distance = in.read<double>();
+        in.readVector(ep.xyoffset);
+        if (source < 0 || target < 0 || source >= static_cast<int32_t>(num_vertices) || target >= static_cast<int32_t>(num_vertices)) {
+            error = path + ": edge " + std::to_string(source) + " -> " + std::to_string(target) + " references a missing vertex";
+            return false;
+        }
+        if (in.ok && invalid.empty())
+            invalid = checkEdge(source, target, ep);
+        boost::add_edge(boost::vertex(source, graph), boost::vertex(target, graph), std::move(ep), graph);
+    }
+
+    if (!in.ok) {
+        error = path + " is truncated";
+        return false;
+    }
+    if (!invalid.empty()) {
+        error = path + ": " + invalid;
+        return false;
+    }
+    return true;
+}
+
+bool readSceneFile(const std::string& path, SceneGraph& graph, Boundary& boundary, std::string& error,
+    std::string* json_text)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+    char magic[4] = {};
+    file.read(magic, 4);
+    if (file.gcount() == 4 && std::memcmp(magic, kSceneBinaryMagic, 4) == 0) {
+        file.close();
+        return readSceneBinary(path, graph, boundary, error);
+    }
+    // One read of the whole file; the SAX parser is fastest on contiguous memory
+    file.clear();
+    file.seekg(0, std::ios::end);
+    std::string text(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(text.data(), text.size());
+    if (!readSceneJson(text.data(), text.data() + text.size(), graph, boundary, error))
+        return false;
+    if (json_text)
+        *json_text = std::move(text);
+    return true;
+}
+
+bool writeSceneBinary(const std::string& path, const SceneGraph& graph, const Boundary& boundary, std::string& error)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        error = "cannot open " + path + " for writing";
+        return false;
+    }
+    BinaryWriter out(file);
+    file.write(kSceneBinaryMagic, 4);
+    out.write(kSceneBinaryVersion);
+    out.write(static_cast<uint32_t>(boost::num_vertices(graph)));
+    out.write(static_cast<uint32_t>(boost::num_edges(graph)));
+
+    out.writeVector(boundary.origin_pos);
+    out.writeVector(boundary.size);
+    out.write(static_cast<uint32_t>(boundary.points.size()));
+    for (const auto& point : boundary.points)
+        out.writeVector(point);
+
+    VertexIterator vi, vi_end;
+    for (boost::tie(vi, vi_end) = boost::vertices(graph); vi != vi_end; ++vi) {
+        const VertexProperties& vp = graph[*vi];
+        out.write(static_cast<int32_t>(vp.id));
+        out.write(static_cast<int32_t>(vp.boundary));
+        out.write(static_cast<int32_t>(vp.corner));
+        out.write(static_cast<int32_t>(vp.orientation));
+        out.write(static_cast<uint8_t>(vp.on_floor));
+        out.write(static_cast<uint8_t>(vp.hanging));
+        out.writeString(vp.label);
+        out.writeVector(vp.target_pos);
+        out.writeVector(vp.target_size);
+        out.writeVector(vp.pos_tolerance);
+        out.writeVector(vp.size_tolerance);
+    }
+
+    EdgeIterator ei, ei_end;
+    for (boost::tie(ei, ei_end) = boost::edges(graph); ei != ei_end; ++ei) {
+        const EdgeProperties& ep = graph[*ei];
+        out.write(static_cast<int32_t>(boost::source(*ei, graph)));
+        out.write(static_cast<int32_t>(boost::target(*ei, graph)));
+        out.write(static_cast<int32_t>(ep.type));
+        out.write(static_cast<int32_t>(ep.align_edge));
+        out.write(ep.distance);
+        out.writeVector(ep.xyoffset);
+    }
+    if (!file) {
+        error = "failed writing " + path;
+        return false;
+    }
+    return true;
+}
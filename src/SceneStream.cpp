@@ -0,0 +1,130 @@
+#include "SceneStream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+SceneStream::SceneStream(int jobs, const std::function<void(Solver&)>& configure)
+{
+    jobs = std::max(1, jobs);
+    window = 2 * static_cast<size_t>(jobs);
+    for (int k = 0; k < jobs; ++k) {
+        solvers.push_back(std::make_unique<Solver>());
+        configure(*solvers.back());
+    }
+}
+
+nlohmann::json SceneStream::errorRecord(const std::string& error)
+{
+    nlohmann::json record;
+    record["conflict_info"] = "";
+    record["plan_info"] = nlohmann::json::array();
+    record["error"] = error;
+    record["solved"] = false;
+    return record;
+}
+
+std::string SceneStream::solveRecord(Solver& solver, const std::string& line, size_t index)
+{
+    auto start = std::chrono::steady_clock::now();
+    nlohmann::json record;
+    std::string error;
+    try {
+        if (!solver.loadSceneText(line, error)) {
+            record = errorRecord(error);
+        }
+        else {
+            solver.solve();
+            record = solver.result();
+            // Infeasible and time-limited scenes also give a record, with the conflict or plan info it has
+            record["solved"] = solver.hasLayout();
+        }
+    }
+    catch (const GRBException& e) {
+        record = errorRecord(e.getMessage());
+    }
+    // Anything else thrown for one scene, such as a malformed record or bad_alloc, must not end the stream
+    catch (const std::exception& e) {
+        record = errorRecord(e.what());
+    }
+    record["record"] = index;
+    record["runtime"] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    // Error messages may quote invalid UTF-8 from the input line
+    return record.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+size_t SceneStream::run(std::istream& in, const std::function<void(const std::string&)>& emit)
+{
+    std::mutex mutex;
+    std::condition_variable work_ready, result_ready;
+    std::deque<std::pair<size_t, std::string>> pending;
+    // Results that finished ahead of an earlier record
+    std::map<size_t, std::string> finished;
+    size_t next_read = 0, next_emit = 0;
+    bool eof = false;
+
+    std::vector<std::thread> workers;
+    for (auto& solver : solvers) {
+        workers.emplace_back([&, worker = solver.get()]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                work_ready.wait(lock, [&] { return eof || !pending.empty(); });
+                if (pending.empty())
+                    return;
+                auto [index, line] = std::move(pending.front());
+                pending.pop_front();
+                lock.unlock();
+                std::string out = solveRecord(*worker, line, index);
+                lock.lock();
+                finished.emplace(index, std::move(out));
+                result_ready.notify_all();
+            }
+        });
+    }
+
+    // Emits the finished prefix without holding the lock; returns with the lock held
+    auto emitReady = [&](std::unique_lock<std::mutex>& lock) {
+        std::vector<std::string> ready;
+        for (auto it = finished.find(next_emit); it != finished.end(); it = finished.find(next_emit)) {
+            ready.push_back(std::move(it->second));
+            finished.erase(it);
+            ++next_emit;
+        }
+        if (ready.empty())
+            return;
+        lock.unlock();
+        for (const auto& out : ready)
+            emit(out);
+        lock.lock();
+    };
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        std::unique_lock<std::mutex> lock(mutex);
+        emitReady(lock);
+        while (next_read - next_emit >= window) {
+            result_ready.wait(lock, [&] { return finished.count(next_emit) > 0; });
+            emitReady(lock);
+        }
+        pending.emplace_back(next_read++, std::move(line));
+        work_ready.notify_one();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    eof = true;
+    work_ready.notify_all();
+    while (next_emit < next_read) {
+        result_ready.wait(lock, [&] { return finished.count(next_emit) > 0; });
+        emitReady(lock);
+    }
+    lock.unlock();
+    for (auto& t : workers)
+        t.join();
+    return next_read;
+}
@@ -1,449 +1,370 @@
 #include "Solver.h"
+#include "MultilevelSolver.h"
+#include "RecordingBackend.h"
+#include "SceneReader.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <boost/graph/graphviz.hpp>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 std::vector<std::string> show_edges = { "Left of", "Right of", "Front of", "Behind", "Above", "Under", "Close by", "Align with" };
 std::vector<std::string> show_orientations = { "up", "down", "left", "right", "front", "back" };
 
-Solver::Solver() : env(), model(env) {
+Solver::Solver() : env(), pool(env), layoutModel(g, boundary) {
     // Initialize solver-related data if needed
     hyperparameters = {1, 1, 1, 1};
+	vertical_decoupled = false;
+	objective_value = 0;
+	has_layout = false;
+	num_layouts = 1;
+	min_binary_difference = 1;
+	min_position_distance = 0;
+	verify_layout = true;
+	build_threads = 0;
+	pool.preset = [this](GRBModel& m) { applyParams(m, solve_params); };
+	clearModel();
 }
 
-Solver::~Solver() {}
+Solver::~Solver() {
+	writer.wait();
+}
 
-bool Solver::has_path(const SceneGraph& g, VertexDescriptor start, VertexDescriptor target)
+void Solver::addConstraints()
 {
-    std::vector<bool> visited_1(boost::num_vertices(g), false), visited_2(boost::num_vertices(g), false),
-		visited_3(boost::num_vertices(g), false), visited_4(boost::num_vertices(g), false),
-		visited_5(boost::num_vertices(g), false), visited_6(boost::num_vertices(g), false);
-	return (dfs_check_path(g, start, target, LeftOf, visited_1) || dfs_check_path(g, start, target, RightOf, visited_1) || 
-		dfs_check_path(g, start, target, FrontOf, visited_3) || dfs_check_path(g, start, target, Behind, visited_4) || 
-		dfs_check_path(g, start, target, Above, visited_5) || dfs_check_path(g, start, target, Under, visited_6));
+	layoutModel.analyze(build_threads);
+	vertical_decoupled = layoutModel.vertical_decoupled;
+	bool build_symmetry = params.break_symmetry;
+	for (const auto& p : portfolio)
+		build_symmetry = build_symmetry || p.break_symmetry;
+	// When decoupled, z/h live in their own continuous model which is solved first
+	layoutModel.build(backend, vertical_decoupled ? verticalBackend : backend, graphProcessor, build_symmetry);
+	features = layoutModel.features;
+	symmetry_constrs = layoutModel.symmetry_rows;
+	symmetry_fixed_vars.clear();
+	for (int var : layoutModel.symmetry_fixed_vars)
+		symmetry_fixed_vars.push_back(backend.vars[var]);
+	layout_binaries.clear();
+	for (int var : layoutModel.layout_binaries)
+		layout_binaries.push_back(backend.vars[var]);
+	layouts.clear();
+	applyObjectiveWeights(hyperparameters);
 }
 
-bool Solver::dfs_check_path(const SceneGraph& g, VertexDescriptor u, VertexDescriptor target, EdgeType required_type, std::vector<bool>& visited)
+void Solver::extractFeatures()
 {
-	if (g[u].id == g[target].id) return true;
-	visited[g[u].id] = true;
-
-	for (const auto& edge : boost::make_iterator_range(boost::out_edges(u, g))) {
-		VertexDescriptor v = boost::target(edge, g);
-		if (!visited[g[v].id] && g[edge].type == required_type) {
-			if (dfs_check_path(g, v, target, required_type, visited)) {
-				return true;
-			}
+	// Counters for pairs, CloseBy/corner binaries and area terms are filled by addConstraints
+	model->update();
+	features.binaries = model->get(GRB_IntAttr_NumBinVars);
+	features.constraints = model->get(GRB_IntAttr_NumConstrs);
+	features.equality_constraints = 0;
+	GRBConstr* constrs = model->getConstrs();
+	for (int i = 0; i < features.constraints; ++i) {
+		if (constrs[i].get(GRB_CharAttr_Sense) == GRB_EQUAL)
+			features.equality_constraints++;
+	}
+	delete[] constrs;
+	if (vertical_decoupled) {
+		verticalModel->update();
+		int vertical_constraints = verticalModel->get(GRB_IntAttr_NumConstrs);
+		constrs = verticalModel->getConstrs();
+		for (int i = 0; i < vertical_constraints; ++i) {
+			if (constrs[i].get(GRB_CharAttr_Sense) == GRB_EQUAL)
+				features.equality_constraints++;
 		}
+		delete[] constrs;
+		features.constraints += vertical_constraints;
 	}
-	return false;
+	features.equality_ratio = features.constraints > 0 ? static_cast<double>(features.equality_constraints) / features.constraints : 0;
 }
 
-void Solver::addConstraints()
+void Solver::logFeatures(double runtime)
 {
-	int num_vertices = boost::num_vertices(g);
-	double M = boundary.size[0] + boundary.size[1] + boundary.size[2];
-	std::vector<GRBVar> x_i(num_vertices), y_i(num_vertices), z_i(num_vertices),
-		l_i(num_vertices), w_i(num_vertices), h_i(num_vertices);
-	std::vector<std::vector<GRBVar>> sigma_L(num_vertices, std::vector<GRBVar>(num_vertices)),
-		sigma_R(num_vertices, std::vector<GRBVar>(num_vertices)),
-		sigma_F(num_vertices, std::vector<GRBVar>(num_vertices)),
-		sigma_B(num_vertices, std::vector<GRBVar>(num_vertices)),
-		sigma_U(num_vertices, std::vector<GRBVar>(num_vertices)),
-		sigma_D(num_vertices, std::vector<GRBVar>(num_vertices)),
-		L(num_vertices, std::vector<GRBVar>(num_vertices)),
-		R(num_vertices, std::vector<GRBVar>(num_vertices)),
-		F(num_vertices, std::vector<GRBVar>(num_vertices)),
-		B(num_vertices, std::vector<GRBVar>(num_vertices));
-	for (int i = 0; i < num_vertices; ++i) {
-		x_i[i] = model.addVar(boundary.origin_pos[0], boundary.origin_pos[0] + boundary.size[0], 0.0, GRB_CONTINUOUS, "x_" + std::to_string(i));
-		y_i[i] = model.addVar(boundary.origin_pos[1], boundary.origin_pos[1] + boundary.size[1], 0.0, GRB_CONTINUOUS, "y_" + std::to_string(i));
-		l_i[i] = model.addVar(0.0, boundary.size[0], 0.0, GRB_CONTINUOUS, "l_" + std::to_string(i));
-		w_i[i] = model.addVar(0.0, boundary.size[1], 0.0, GRB_CONTINUOUS, "w_" + std::to_string(i));
-		z_i[i] = model.addVar(boundary.origin_pos[2], boundary.origin_pos[2] + boundary.size[2], 0.0, GRB_CONTINUOUS, "z_" + std::to_string(i));
-		h_i[i] = model.addVar(0.0, boundary.size[2], 0.0, GRB_CONTINUOUS, "h_" + std::to_string(i));
-	}
-	// Inside Constraints & tolerance Constraint
-	VertexIterator vi, vi_end;
-	for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
-		model.addConstr(x_i[g[*vi].id] - l_i[g[*vi].id] / 2 >= boundary.origin_pos[0], "Inside_Object_" + std::to_string(g[*vi].id) + "_x_left");
-		model.addConstr(x_i[g[*vi].id] + l_i[g[*vi].id] / 2 <= boundary.origin_pos[0] + boundary.size[0], "Inside_Object_" + std::to_string(g[*vi].id) + "_x_right");
-		model.addConstr(y_i[g[*vi].id] - w_i[g[*vi].id] / 2 >= boundary.origin_pos[1], "Inside_Object_" + std::to_string(g[*vi].id) + "_y_back");
-		model.addConstr(y_i[g[*vi].id] + w_i[g[*vi].id] / 2 <= boundary.origin_pos[1] + boundary.size[1], "Inside_Object_" + std::to_string(g[*vi].id) + "_y_front");
-		model.addConstr(z_i[g[*vi].id] - h_i[g[*vi].id] / 2 >= boundary.origin_pos[2], "Inside_Object_" + std::to_string(g[*vi].id) + "_z_bottom");
-		model.addConstr(z_i[g[*vi].id] + h_i[g[*vi].id] / 2 <= boundary.origin_pos[2] + boundary.size[2], "Inside_Object_" + std::to_string(g[*vi].id) + "_z_top");
-		if (!g[*vi].pos_tolerance.empty() && !g[*vi].target_pos.empty()) {
-			model.addConstr(x_i[g[*vi].id] >= g[*vi].target_pos[0] - g[*vi].pos_tolerance[0], "Pos_Tolerance_Object_" + std::to_string(g[*vi].id) + "_x_left");
-			model.addConstr(x_i[g[*vi].id] <= g[*vi].target_pos[0] + g[*vi].pos_tolerance[0], "Pos_Tolerance_Object_" + std::to_string(g[*vi].id) + "_x_right");
-			model.addConstr(y_i[g[*vi].id] >= g[*vi].target_pos[1] - g[*vi].pos_tolerance[1], "Pos_Tolerance_Object_" + std::to_string(g[*vi].id) + "_y_back");
-			model.addConstr(y_i[g[*vi].id] <= g[*vi].target_pos[1] + g[*vi].pos_tolerance[1], "Pos_Tolerance_Object_" + std::to_string(g[*vi].id) + "_y_front");
-			model.addConstr(z_i[g[*vi].id] >= g[*vi].target_pos[2] - g[*vi].pos_tolerance[2], "Pos_Tolerance_Object_" + std::to_string(g[*vi].id) + "_z_bottom");
-			model.addConstr(z_i[g[*vi].id] <= g[*vi].target_pos[2] + g[*vi].pos_tolerance[2], "Pos_Tolerance_Object_" + std::to_string(g[*vi].id) + "_z_top");
-		}
-		if (!g[*vi].size_tolerance.empty() && !g[*vi].target_size.empty()) {
-			model.addConstr(l_i[g[*vi].id] >= g[*vi].target_size[0] - g[*vi].size_tolerance[0], "Size_Tolerance_Object_" + std::to_string(g[*vi].id) + "_l_min");
-			model.addConstr(l_i[g[*vi].id] <= g[*vi].target_size[0] + g[*vi].size_tolerance[0], "Size_Tolerance_Object_" + std::to_string(g[*vi].id) + "_l_max");
-			model.addConstr(w_i[g[*vi].id] >= g[*vi].target_size[1] - g[*vi].size_tolerance[1], "Size_Tolerance_Object_" + std::to_string(g[*vi].id) + "_w_min");
-			model.addConstr(w_i[g[*vi].id] <= g[*vi].target_size[1] + g[*vi].size_tolerance[1], "Size_Tolerance_Object_" + std::to_string(g[*vi].id) + "_w_max");
-			model.addConstr(h_i[g[*vi].id] >= g[*vi].target_size[2] - g[*vi].size_tolerance[2], "Size_Tolerance_Object_" + std::to_string(g[*vi].id) + "_h_min");
-			model.addConstr(h_i[g[*vi].id] <= g[*vi].target_size[2] + g[*vi].size_tolerance[2], "Size_Tolerance_Object_" + std::to_string(g[*vi].id) + "_h_max");
-		}
+	// One JSON line per solve, the training data for retuning the profile table offline
+	nlohmann::json record;
+	record["scene"] = inputpath;
+	record["features"] = SolverProfiles::toJson(features);
+	record["profile"] = solve_params.name;
+	record["time_limit"] = solve_params.time_limit;
+	record["runtime"] = runtime;
+	record["solved"] = !solution.empty();
+	record["objective"] = solution.empty() ? nlohmann::json() : nlohmann::json(objective_value);
+	record["mip_gap"] = nullptr;
+	try {
+		if (portfolio.size() <= 1 && !solution.empty() && model->get(GRB_IntAttr_IsMIP))
+			record["mip_gap"] = model->get(GRB_DoubleAttr_MIPGap);
 	}
-	// On floor Constraints
-	for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
-		if (g[*vi].on_floor) {
-			model.addConstr(z_i[g[*vi].id] == boundary.origin_pos[2] + h_i[g[*vi].id] / 2, "On_Floor_Object_" + std::to_string(g[*vi].id));
-		}
+	catch (GRBException e) {}
+	// Solvers of a stream run append to the same log from several threads
+	static std::mutex log_mutex;
+	std::lock_guard<std::mutex> lock(log_mutex);
+	std::ofstream ofs(features_log, std::ios::app);
+	if (!ofs.is_open()) {
+		std::cerr << "Failed to open features log: " << features_log << std::endl;
+		return;
 	}
-	// Hanging Constraints
-	for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
-		if (g[*vi].hanging) {
-			model.addConstr(z_i[g[*vi].id] == boundary.origin_pos[2] + boundary.size[2] - h_i[g[*vi].id] / 2, "Hanging_Object_" + std::to_string(g[*vi].id));
-		}
+	ofs << record.dump() << std::endl;
+}
+
+void Solver::applyObjectiveWeights(const std::vector<double>& weights)
+{
+	// The weighted sum is merged once more, so each model receives a single expression without duplicate terms
+	ObjectiveAssembler obj, vertical_obj;
+	for (size_t k = 0; k < layoutModel.objective_terms.size(); ++k) {
+		obj.add(layoutModel.objective_terms[k], weights[k]);
+		vertical_obj.add(layoutModel.vertical_objective_terms[k], weights[k]);
 	}
-	// Adjacency Constraints
-	EdgeIterator ei, ei_end;
-	for (boost::tie(ei, ei_end) = boost::edges(g); ei != ei_end; ++ei) {
-		VertexDescriptor source = boost::source(*ei, g);
-		VertexDescriptor target = boost::target(*ei, g);
-		int ids = g[source].id, idt = g[target].id;
-		switch(g[*ei].type)
-		{
-		case LeftOf:
-			if (g[*ei].distance >= 0)
-				model.addConstr(x_i[ids] + l_i[ids] / 2 <= x_i[idt] - l_i[idt] / 2, "Object_" + std::to_string(ids) + "_LeftOf_Object_" + std::to_string(idt));
-			else
-				model.addConstr(x_i[ids] + l_i[ids] / 2 == x_i[idt] - l_i[idt] / 2, "Object_" + std::to_string(ids) + "_LeftOf_Object_" + std::to_string(idt));
-			break;
-		case RightOf:
-			if (g[*ei].distance >= 0)
-				model.addConstr(x_i[ids] - l_i[ids] / 2 >= x_i[idt] + l_i[idt] / 2, "Object_" + std::to_string(ids) + "_RightOf_Object_" + std::to_string(idt));
-			else
-				model.addConstr(x_i[ids] - l_i[ids] / 2 == x_i[idt] + l_i[idt] / 2, "Object_" + std::to_string(ids) + "_RightOf_Object_" + std::to_string(idt));
-			break;
-		case Behind:
-			if (g[*ei].distance >= 0)
-				model.addConstr(y_i[ids] + w_i[ids] / 2 <= y_i[idt] - w_i[idt] / 2, "Object_" + std::to_string(ids) + "_Behind_Object_" + std::to_string(idt));
-			else
-				model.addConstr(y_i[ids] + w_i[ids] / 2 == y_i[idt] - w_i[idt] / 2, "Object_" + std::to_string(ids) + "_Behind_Object_" + std::to_string(idt));
-			break;
-		case FrontOf:
-			if (g[*ei].distance >= 0)
-				model.addConstr(y_i[ids] - w_i[ids] / 2 >= y_i[idt] + w_i[idt] / 2, "Object_" + std::to_string(ids) + "_FrontOf_Object_" + std::to_string(idt));
-			else
-				model.addConstr(y_i[ids] - w_i[ids] / 2 == y_i[idt] + w_i[idt] / 2, "Object_" + std::to_string(ids) + "_FrontOf_Object_" + std::to_string(idt));
-			break;
-		case Under:
-			model.addConstr(z_i[ids] + h_i[ids] / 2 == z_i[idt] - h_i[idt] / 2, "Object_" + std::to_string(ids) + "_Under_Object_" + std::to_string(idt));
-			break;
-		case Above:
-			model.addConstr(z_i[ids] - h_i[ids] / 2 == z_i[idt] + h_i[idt] / 2, "Object_" + std::to_string(ids) + "_Above_Object_" + std::to_string(idt));
-			break;
-		case CloseBy:
-			L[ids][idt] = model.addVar(0, 1, 0, GRB_BINARY);
-			R[ids][idt] = model.addVar(0, 1, 0, GRB_BINARY);
-			F[ids][idt] = model.addVar(0, 1, 0, GRB_BINARY);
-			B[ids][idt] = model.addVar(0, 1, 0, GRB_BINARY);
-			model.addConstr(x_i[ids] - l_i[ids] / 2 <= x_i[idt] + l_i[idt] / 2 + M * (1 - R[ids][idt]), "Object_" + std::to_string(ids) + "_CloseBy_Object_" + std::to_string(idt) + "ieqa");
-			model.addConstr(x_i[ids] + l_i[ids] / 2 >= x_i[idt] - l_i[idt] / 2 - M * (1 - L[ids][idt]), "Object_" + std::to_string(ids) + "_CloseBy_Object_" + std::to_string(idt) + "ieqb");
-			model.addConstr(y_i[ids] - w_i[ids] / 2 <= y_i[idt] + w_i[idt] / 2 + M * (1 - F[ids][idt]), "Object_" + std::to_string(ids) + "_CloseBy_Object_" + std::to_string(idt) + "ieqc");
-			model.addConstr(y_i[ids] + w_i[ids] / 2 >= y_i[idt] - w_i[idt] / 2 - M * (1 - B[ids][idt]), "Object_" + std::to_string(ids) + "_CloseBy_Object_" + std::to_string(idt) + "ieqd");
-			model.addConstr(L[ids][idt] + R[ids][idt] + F[ids][idt] + B[ids][idt] <= 1, "Object_" + std::to_string(ids) + "_CloseBy_Object_" + std::to_string(idt) + "ieqe");
-			break;
-		case AlignWith:
-			switch (g[*ei].align_edge)
-			{
-			case 0:
-				model.addConstr(y_i[ids] - w_i[ids] / 2 == y_i[idt] - w_i[idt] / 2, "Object_" + std::to_string(ids) + "_AlignWith_Object_" + std::to_string(idt));
-				break;
-			case 1:
-				model.addConstr(x_i[ids] + l_i[ids] / 2 == x_i[idt] + l_i[idt] / 2, "Object_" + std::to_string(ids) + "_AlignWith_Object_" + std::to_string(idt));
-				break;
-			case 2:
-				model.addConstr(y_i[ids] + w_i[ids] / 2 == y_i[idt] + w_i[idt] / 2, "Object_" + std::to_string(ids) + "_AlignWith_Object_" + std::to_string(idt));
-				break;
-			case 3:
-				model.addConstr(x_i[ids] - l_i[ids] / 2 == x_i[idt] - l_i[idt] / 2, "Object_" + std::to_string(ids) + "_AlignWith_Object_" + std::to_string(idt));
-				break;
-			case 4:
-				model.addConstr(z_i[ids] - h_i[ids] / 2 == z_i[idt] + h_i[idt] / 2, "Object_" + std::to_string(ids) + "_AlignWith_Object_" + std::to_string(idt));
-				break;
-			case 5:
-				model.addConstr(z_i[ids] + h_i[ids] / 2 == z_i[idt] - h_i[idt] / 2, "Object_" + std::to_string(ids) + "_AlignWith_Object_" + std::to_string(idt));
-				break;
-			default:break;
-			}
-			break;
-		default:break;
-		}
+	if (vertical_decoupled) {
+		backend.setObjective(obj);
+		verticalBackend.setObjective(vertical_obj);
 	}
-	// Non overlap Constraints
-	auto vi_start_end = boost::vertices(g);
-	VertexIterator vj;
-	for (vi = vi_start_end.first; vi != vi_start_end.second; ++vi) {
-		for (vj = vi_start_end.first; vj != vi_start_end.second; ++vj) {
-			if (g[*vi].id < g[*vj].id && !has_path(g, *vi, *vj) && !has_path(g, *vj, *vi)) {
-				sigma_R[g[*vi].id][g[*vj].id] = model.addVar(0, 1, 0, GRB_BINARY);
-				sigma_L[g[*vi].id][g[*vj].id] = model.addVar(0, 1, 0, GRB_BINARY);
-				sigma_F[g[*vi].id][g[*vj].id] = model.addVar(0, 1, 0, GRB_BINARY);
-				sigma_B[g[*vi].id][g[*vj].id] = model.addVar(0, 1, 0, GRB_BINARY);
-				model.addConstr(x_i[g[*vi].id] - l_i[g[*vi].id] / 2 >= x_i[g[*vj].id] + l_i[g[*vj].id] / 2 -
-					M * (1 - sigma_R[g[*vi].id][g[*vj].id]), "NonOverlap_Object_" + std::to_string(g[*vi].id) + "and_Object_" + std::to_string(g[*vj].id) + "R");
-				model.addConstr(x_i[g[*vi].id] + l_i[g[*vi].id] / 2 <= x_i[g[*vj].id] - l_i[g[*vj].id] / 2 +
-					M * (1 - sigma_L[g[*vi].id][g[*vj].id]), "NonOverlap_Object_" + std::to_string(g[*vi].id) + "and_Object_" + std::to_string(g[*vj].id) + "L");
-				model.addConstr(y_i[g[*vi].id] - w_i[g[*vi].id] / 2 >= y_i[g[*vj].id] + w_i[g[*vj].id] / 2 - 
-					M * (1 - sigma_F[g[*vi].id][g[*vj].id]), "NonOverlap_Object_" + std::to_string(g[*vi].id) + "and_Object_" + std::to_string(g[*vj].id) + "F");
-				model.addConstr(y_i[g[*vi].id] + w_i[g[*vi].id] / 2 <= y_i[g[*vj].id] - w_i[g[*vj].id] / 2 + 
-					M * (1 - sigma_B[g[*vi].id][g[*vj].id]), "NonOverlap_Object_" + std::to_string(g[*vi].id) + "and_Object_" + std::to_string(g[*vj].id) + "B");
-
-				sigma_U[g[*vi].id][g[*vj].id] = model.addVar(0, 1, 0, GRB_BINARY);
-				sigma_D[g[*vi].id][g[*vj].id] = model.addVar(0, 1, 0, GRB_BINARY);
-				model.addConstr(z_i[g[*vi].id] - h_i[g[*vi].id] / 2 >= z_i[g[*vj].id] + h_i[g[*vj].id] / 2 -
-					M * (1 - sigma_U[g[*vi].id][g[*vj].id]), "NonOverlap_Object_" + std::to_string(g[*vi].id) + "and_Object_" + std::to_string(g[*vj].id) + "U");
-				model.addConstr(z_i[g[*vi].id] + h_i[g[*vi].id] / 2 <= z_i[g[*vj].id] - h_i[g[*vj].id] / 2 +
-					M * (1 - sigma_D[g[*vi].id][g[*vj].id]), "NonOverlap_Object_" + std::to_string(g[*vi].id) + "and_Object_" + std::to_string(g[*vj].id) + "D");
-				model.addConstr(sigma_L[g[*vi].id][g[*vj].id] + sigma_R[g[*vi].id][g[*vj].id] +
-					sigma_F[g[*vi].id][g[*vj].id] + sigma_B[g[*vi].id][g[*vj].id] +
-					sigma_U[g[*vi].id][g[*vj].id] + sigma_D[g[*vi].id][g[*vj].id] >= 1, "NonOverlap_Object_" + std::to_string(g[*vi].id) + "and_Object_" + std::to_string(g[*vj].id));
-			}
+	else {
+		obj.add(vertical_obj, 1);
+		backend.setObjective(obj);
+	}
+}
+
+void Solver::applyParams(GRBModel& m, const SolverParams& p)
+{
+	m.set(GRB_DoubleParam_TimeLimit, p.time_limit);
+	m.set(GRB_DoubleParam_MIPGap, p.mip_gap);
+	m.set(GRB_IntParam_MIPFocus, p.mip_focus);
+	m.set(GRB_IntParam_Method, p.method);
+	m.set(GRB_DoubleParam_BarConvTol, p.bar_conv_tol);
+	m.set(GRB_IntParam_Cuts, p.cuts);
+	m.set(GRB_IntParam_Presolve, p.presolve);
+	m.set(GRB_IntParam_Seed, p.seed);
+	m.set(GRB_IntParam_Threads, p.threads);
+}
+
+std::vector<SolverParams> Solver::defaultPortfolio(int members)
+{
+	std::vector<SolverParams> variants(4);
+	// Gurobi's own defaults
+	variants[1].name = "balanced";
+	variants[1].mip_focus = 0;
+	variants[1].method = -1;
+	variants[1].cuts = -1;
+	variants[1].presolve = -1;
+	variants[1].seed = 1;
+	// Push the bound: aggressive presolve, focus on proving optimality
+	variants[2].name = "optimality";
+	variants[2].mip_focus = 2;
+	variants[2].presolve = 2;
+	variants[2].cuts = 1;
+	variants[2].seed = 2;
+	// Alternative formulation without symmetry breaking rows, dual simplex at the root
+	variants[3].name = "no-symmetry";
+	variants[3].mip_focus = 3;
+	variants[3].method = 1;
+	variants[3].break_symmetry = false;
+	variants[3].seed = 3;
+
+	members = std::max(members, 1);
+	int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / members);
+	std::vector<SolverParams> portfolio;
+	for (int k = 0; k < members; ++k) {
+		SolverParams p = variants[k % variants.size()];
+		if (k >= static_cast<int>(variants.size())) {
+			p.seed = k;
+			p.name += "-seed" + std::to_string(k);
 		}
+		p.threads = threads;
+		portfolio.push_back(p);
 	}
-	// Boundary Constraints
-	for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
-		if (g[*vi].boundary >= 0) {
-			double x1 = boundary.points[g[*vi].boundary][0], x2 = boundary.points[(g[*vi].boundary + 1) % boundary.Orientations.size()][0];
-			double y1 = boundary.points[g[*vi].boundary][1], y2 = boundary.points[(g[*vi].boundary + 1) % boundary.Orientations.size()][1];
-			double x1_ = std::min(x1, x2), x2_ = std::max(x1, x2);
-			double y1_ = std::min(y1, y2), y2_ = std::max(y1, y2);
-			switch (boundary.Orientations[g[*vi].boundary])
-			{
-			case LEFT:
-				model.addConstr(x_i[g[*vi].id] - l_i[g[*vi].id] / 2 == x1_, "Boundary_Object_" + std::to_string(g[*vi].id) + "_Left_eq");
-				// Here we assume that on boundary means at least half of length is on the wall
-				model.addConstr(y_i[g[*vi].id] >= y1_, "Boundary_Object_" + std::to_string(g[*vi].id) + "_Left_ieq");
-				model.addConstr(y_i[g[*vi].id] <= y2_, "Boundary_Object_" + std::to_string(g[*vi].id) + "_Left_ieqq");
-				break;
-			case RIGHT:
-				model.addConstr(x_i[g[*vi].id] + l_i[g[*vi].id] / 2 == x1_, "Boundary_Object_" + std::to_string(g[*vi].id) + "_Right_eq");
-				model.addConstr(y_i[g[*vi].id] >= y1_, "Boundary_Object_" + std::to_string(g[*vi].id) + "_Right_ieq");
-				model.addConstr(y_i[g[*vi].id] <= y2_, "Boundary_Object_" + std::to_string(g[*vi].id) + "_Right_ieqq");
-				break;
-			case FRONT:
-				model.addConstr(y_i[g[*vi].id] + w_i[g[*vi].id] / 2 == y1_, "Boundary_Object_" + std::to_string(g[*vi].id) + "_Front_eq");
-				model.addConstr(x_i[g[*vi].id] >= x1_, "Boundary_Object_" + std::to_string(g[*vi].id) + "_Front_ieq");
-				model.addConstr(x_i[g[*vi].id] <= x2_, "Boundary_Object_" + std::to_string(g[*vi].id) + "_Front_ieqq");
-				break;
-			case BACK:
-				model.addConstr(y_i[g[*vi].id] - w_i[g[*vi].id] / 2 == y1_, "Boundary_Object_" + std::to_string(g[*vi].id) + "_Back_eq");
-				model.addConstr(x_i[g[*vi].id] >= x1_, "Boundary_Object_" + std::to_string(g[*vi].id) + "_Back_ieq");
-				model.addConstr(x_i[g[*vi].id] <= x2_, "Boundary_Object_" + std::to_string(g[*vi].id) + "_Back_ieqq");
-				break;
-			default:break;
-			}
+	return portfolio;
+}
+
+bool Solver::optimizePortfolio()
+{
+	model->update();
+	int numVars = model->get(GRB_IntAttr_NumVars);
+	// A thread budget runs at most one member per thread
+	size_t members = portfolio.size();
+	if (budget.threads > 0)
+		members = std::min(members, static_cast<size_t>(budget.threads));
+	PortfolioShared shared;
+	shared.target_gap = solve_params.mip_gap;
+
+	// Every member gets its own environment and a copy of the built model
+	std::vector<std::unique_ptr<GRBEnv>> envs;
+	std::vector<std::unique_ptr<GRBModel>> copies;
+	for (size_t k = 0; k < members; ++k) {
+		SolverParams p = portfolio[k];
+		applyBudget(p, static_cast<int>(members));
+		envs.push_back(std::make_unique<GRBEnv>());
+		copies.push_back(std::make_unique<GRBModel>(*model, *envs.back()));
+		GRBModel& copy = *copies.back();
+		if (!p.break_symmetry) {
+			for (const auto& name : symmetry_constrs)
+				copy.remove(copy.getConstrByName(name));
+			GRBVar* copyVars = copy.getVars();
+			for (const auto& var : symmetry_fixed_vars)
+				copyVars[var.index()].set(GRB_DoubleAttr_UB, 1.0);
+			delete[] copyVars;
 		}
+		applyParams(copy, p);
+		copy.set(GRB_DoubleParam_MIPGap, shared.target_gap);
 	}
-	// Corner Constraints
-	std::vector<std::vector<GRBVar>> cor(num_vertices);
-	for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
-		switch (g[*vi].corner)
-		{
-			case BOTTOMLEFT:
-			{
-				int num = boundary.BLcorner.size();
-				cor[g[*vi].id].resize(num);
-				GRBLinExpr posx, posy, cors;
-				for (int i = 0; i < num; ++i) {
-					cor[g[*vi].id][i] = model.addVar(0.0, 1.0, 0.0, GRB_BINARY);
-					posx += boundary.points[boundary.BLcorner[i]][0] * cor[g[*vi].id][i];
-					posy += boundary.points[boundary.BLcorner[i]][1] * cor[g[*vi].id][i];
-					cors += cor[g[*vi].id][i];
-				}
-				model.addConstr(cors == 1, "BottomLeft_Corner_of_Object_" + std::to_string(g[*vi].id) + "eqa");
-				model.addConstr(x_i[g[*vi].id] - l_i[g[*vi].id] / 2 == posx, "BottomLeft_Corner_of_Object_" + std::to_string(g[*vi].id) + "eqb");
-				model.addConstr(y_i[g[*vi].id] - w_i[g[*vi].id] / 2 == posy, "BottomLeft_Corner_of_Object_" + std::to_string(g[*vi].id) + "eqc");
-				break;
-			}
-			case BOTTOMRIGHT:
-			{
-				int num = boundary.BRcorner.size();
-				cor[g[*vi].id].resize(num);
-				GRBLinExpr posx, posy, cors;
-				for (int i = 0; i < num; ++i) {
-					cor[g[*vi].id][i] = model.addVar(0.0, 1.0, 0.0, GRB_BINARY);
-					posx += boundary.points[boundary.BRcorner[i]][0] * cor[g[*vi].id][i];
-					posy += boundary.points[boundary.BRcorner[i]][1] * cor[g[*vi].id][i];
-					cors += cor[g[*vi].id][i];
-				}
-				model.addConstr(cors == 1, "BottomRight_Corner_of_Object_" + std::to_string(g[*vi].id) + "eqa");
-				model.addConstr(x_i[g[*vi].id] + l_i[g[*vi].id] / 2 == posx, "BottomRight_Corner_of_Object_" + std::to_string(g[*vi].id) + "eqb");
-				model.addConstr(y_i[g[*vi].id] - w_i[g[*vi].id] / 2 == posy, "BottomRight_Corner_of_Object_" + std::to_string(g[*vi].id) + "eqc");
-				break;
-			}
-			case TOPLEFT:
-			{
-				int num = boundary.TLcorner.size();
-				cor[g[*vi].id].resize(num);
-				GRBLinExpr posx, posy, cors;
-				for (int i = 0; i < num; ++i) {
-					cor[g[*vi].id][i] = model.addVar(0.0, 1.0, 0.0, GRB_BINARY);
-					posx += boundary.points[boundary.TLcorner[i]][0] * cor[g[*vi].id][i];
-					posy += boundary.points[boundary.TLcorner[i]][1] * cor[g[*vi].id][i];
-					cors += cor[g[*vi].id][i];
+
+	std::vector<int> status(members, GRB_LOADED);
+	std::vector<std::thread> threads;
+	for (size_t k = 0; k < members; ++k) {
+		threads.emplace_back([&, k]() {
+			GRBModel& copy = *copies[k];
+			GRBVar* vars = copy.getVars();
+			try {
+				PortfolioCallback callback(shared, vars, numVars, static_cast<int>(k));
+				copy.setCallback(&callback);
+				copy.optimize();
+				status[k] = copy.get(GRB_IntAttr_Status);
+				if (copy.get(GRB_IntAttr_SolCount) > 0) {
+					double obj = copy.get(GRB_DoubleAttr_ObjVal);
+					double* x = copy.get(GRB_DoubleAttr_X, vars, numVars);
+					std::lock_guard<std::mutex> lock(shared.mutex);
+					if (obj < shared.best_obj) {
+						shared.best_obj = obj;
+						shared.best_x.assign(x, x + numVars);
+						shared.best_member = static_cast<int>(k);
+					}
+					delete[] x;
 				}
-				model.addConstr(cors == 1, "TopLeft_Corner_of_Object_" + std::to_string(g[*vi].id) + "eqa");
-				model.addConstr(x_i[g[*vi].id] - l_i[g[*vi].id] / 2 == posx, "TopLeft_Corner_of_Object_" + std::to_string(g[*vi].id) + "eqb");
-				model.addConstr(y_i[g[*vi].id] + w_i[g[*vi].id] / 2 == posy, "TopLeft_Corner_of_Object_" + std::to_string(g[*vi].id) + "eqc");
-				break;
+				// The first member that proves its gap stops the others
+				if (status[k] == GRB_OPTIMAL)
+					shared.done = true;
 			}
-			case TOPRIGHT:
-			{
-				int num = boundary.TRcorner.size();
-				cor[g[*vi].id].resize(num);
-				GRBLinExpr posx, posy, cors;
-				for (int i = 0; i < num; ++i) {
-					cor[g[*vi].id][i] = model.addVar(0.0, 1.0, 0.0, GRB_BINARY);
-					posx += boundary.points[boundary.TRcorner[i]][0] * cor[g[*vi].id][i];
-					posy += boundary.points[boundary.TRcorner[i]][1] * cor[g[*vi].id][i];
-					cors += cor[g[*vi].id][i];
-				}
-				model.addConstr(cors == 1, "TopRight_Corner_of_Object_" + std::to_string(g[*vi].id) + "eqa");
-				model.addConstr(x_i[g[*vi].id] + l_i[g[*vi].id] / 2 == posx, "TopRight_Corner_of_Object_" + std::to_string(g[*vi].id) + "eqb");
-				model.addConstr(y_i[g[*vi].id] + w_i[g[*vi].id] / 2 == posy, "TopRight_Corner_of_Object_" + std::to_string(g[*vi].id) + "eqc");
-				break;
+			catch (GRBException e) {
+				std::cout << "Portfolio member " << portfolio[k].name << " failed: " << e.getMessage() << std::endl;
 			}
-			default: break;
-		}
+			delete[] vars;
+		});
 	}
-	
-	
-	// Objective Function
-	// Notice that hyperparameters are the weights of area, size error, position error, adjacency error.
-	GRBQuadExpr obj1 = hyperparameters[0], obj2 = 0, obj3 = 0, obj4 = 0;
-	int num2 = 0, num3 = 0, num4 = 0;
-	for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
-		bool area_flag = true;
-		boost::graph_traits<SceneGraph>::out_edge_iterator e_out, e_end;
-		for (boost::tie(e_out, e_end) = boost::out_edges(*vi, g); e_out != e_end; ++e_out) {
-			if (g[*e_out].type == Above || g[*e_out].type == Under) {
-				area_flag = false;
-				break;
-			}
+	for (auto& t : threads)
+		t.join();
+
+	if (shared.best_x.empty()) {
+		if (std::all_of(status.begin(), status.end(), [](int st) { return st == GRB_INFEASIBLE; })) {
+			std::cout << "Model is infeasible. Calling IIS computation..." << std::endl;
+			handleInfeasibleModel(*model);
+		}
+		else {
+			std::cout << "No solution found by the portfolio" << std::endl;
 		}
-		if (area_flag)
-			obj1 -= hyperparameters[0] * l_i[g[*vi].id] * w_i[g[*vi].id] / boundary.size[0] / boundary.size[1];
-		if (!g[*vi].target_size.empty()) {
-			obj2 += hyperparameters[1] * (l_i[g[*vi].id] - g[*vi].target_size[0]) * (l_i[g[*vi].id] - g[*vi].target_size[0]) / boundary.size[0] / boundary.size[0];
-			obj2 += hyperparameters[1] * (w_i[g[*vi].id] - g[*vi].target_size[1]) * (w_i[g[*vi].id] - g[*vi].target_size[1]) / boundary.size[1] / boundary.size[1];
-			obj2 += hyperparameters[1] * (h_i[g[*vi].id] - g[*vi].target_size[2]) * (h_i[g[*vi].id] - g[*vi].target_size[2]) / boundary.size[2] / boundary.size[2];
-			num2++;
+		return false;
+	}
+	std::cout << "Portfolio best solution from member " << portfolio[shared.best_member].name << std::endl;
+	solution = shared.best_x;
+	objective_value = shared.best_obj;
+	return true;
+}
+
+void Solver::collectLayouts()
+{
+	GRBVar* vars = model->getVars();
+	int numVars = model->get(GRB_IntAttr_NumVars);
+	int numVertices = boost::num_vertices(g);
+	std::vector<int> binaries;
+	for (const auto& var : layout_binaries)
+		binaries.push_back(var.index());
+	// Column of x, y, l, w (and z, h when they live in the same model) for every object
+	std::vector<std::vector<int>> columns(numVertices);
+	std::vector<std::vector<double>> vertical(numVertices, { 0, 0 });
+	for (int v = 0; v < numVertices; ++v) {
+		std::string id = std::to_string(v);
+		for (const char* name : { "x_", "y_", "l_", "w_" })
+			columns[v].push_back(model->getVarByName(name + id).index());
+		if (vertical_decoupled) {
+			vertical[v][0] = verticalModel->getVarByName("z_" + id).get(GRB_DoubleAttr_X);
+			vertical[v][1] = verticalModel->getVarByName("h_" + id).get(GRB_DoubleAttr_X);
 		}
-		if (!g[*vi].target_pos.empty()) {
-			obj3 += hyperparameters[2] * (x_i[g[*vi].id] - g[*vi].target_pos[0]) * (x_i[g[*vi].id] - g[*vi].target_pos[0]) / boundary.size[0] / boundary.size[0];
-			obj3 += hyperparameters[2] * (y_i[g[*vi].id] - g[*vi].target_pos[1]) * (y_i[g[*vi].id] - g[*vi].target_pos[1]) / boundary.size[1] / boundary.size[1];
-			obj3 += hyperparameters[2] * (z_i[g[*vi].id] - g[*vi].target_pos[2]) * (z_i[g[*vi].id] - g[*vi].target_pos[2]) / boundary.size[2] / boundary.size[2];
-			num3++;
+		else {
+			columns[v].push_back(model->getVarByName("z_" + id).index());
+			columns[v].push_back(model->getVarByName("h_" + id).index());
 		}
 	}
-	for (boost::tie(ei, ei_end) = boost::edges(g); ei != ei_end; ++ei) {
-		VertexDescriptor source = boost::source(*ei, g);
-		VertexDescriptor target = boost::target(*ei, g);
-		std::vector<double> offset = g[*ei].xyoffset;
-		if (offset.empty())
-			offset = { 0, 0 };
-		if (g[*ei].distance >= 0) {
-			switch (g[*ei].type)
-			{
-			case LeftOf:
-				obj4 += hyperparameters[3] * (x_i[g[target].id] - l_i[g[target].id] / 2 - x_i[g[source].id] - l_i[g[source].id] / 2 - g[*ei].distance) *
-					(x_i[g[target].id] - l_i[g[target].id] / 2 - x_i[g[source].id] - l_i[g[source].id] / 2 - g[*ei].distance) / boundary.size[0] / boundary.size[0];
-				num4++;
-				break;
-			case RightOf:
-				obj4 += hyperparameters[3] * (x_i[g[source].id] - l_i[g[source].id] / 2 - x_i[g[target].id] - l_i[g[target].id] / 2 - g[*ei].distance) *
-					(x_i[g[source].id] - l_i[g[source].id] / 2 - x_i[g[target].id] - l_i[g[target].id] / 2 - g[*ei].distance) / boundary.size[0] / boundary.size[0];
-				num4++;
-				break;
-			case Behind:
-				obj4 += hyperparameters[3] * (y_i[g[target].id] - w_i[g[target].id] / 2 - y_i[g[source].id] - w_i[g[source].id] / 2 - g[*ei].distance) *
-					(y_i[g[target].id] - w_i[g[target].id] / 2 - y_i[g[source].id] - w_i[g[source].id] / 2 - g[*ei].distance) / boundary.size[1] / boundary.size[1];
-				num4++;
-				break;
-			case FrontOf:
-				obj4 += hyperparameters[3] * (y_i[g[source].id] - w_i[g[source].id] / 2 - y_i[g[target].id] - w_i[g[target].id] / 2 - g[*ei].distance) *
-					(y_i[g[source].id] - w_i[g[source].id] / 2 - y_i[g[target].id] - w_i[g[target].id] / 2 - g[*ei].distance) / boundary.size[1] / boundary.size[1];
-				num4++;
-				break;
-			default:break;
+
+	std::vector<std::vector<double>> accepted_x;
+	int solCount = model->get(GRB_IntAttr_SolCount);
+	for (int k = 0; k < solCount && static_cast<int>(layouts.size()) < num_layouts; ++k) {
+		model->set(GRB_IntParam_SolutionNumber, k);
+		double* xn = model->get(GRB_DoubleAttr_Xn, vars, numVars);
+		std::vector<double> x(xn, xn + numVars);
+		delete[] xn;
+
+		Layout layout;
+		layout.objective = model->get(GRB_DoubleAttr_PoolObjVal);
+		for (int v = 0; v < numVertices; ++v) {
+			const auto& c = columns[v];
+			double z = vertical_decoupled ? vertical[v][0] : x[c[4]];
+			double h = vertical_decoupled ? vertical[v][1] : x[c[5]];
+			layout.pos.push_back({ x[c[0]], x[c[1]], z });
+			layout.size.push_back({ x[c[2]], x[c[3]], h });
+		}
+		// Keep the candidate only if it differs enough from every layout kept so far
+		bool diverse = true;
+		for (size_t a = 0; a < layouts.size() && diverse; ++a) {
+			int flips = 0;
+			for (int b : binaries)
+				flips += std::abs(std::round(x[b]) - std::round(accepted_x[a][b])) > 0.5;
+			double moved = 0;
+			for (int v = 0; v < numVertices; ++v) {
+				double dx = layout.pos[v][0] - layouts[a].pos[v][0], dy = layout.pos[v][1] - layouts[a].pos[v][1];
+				moved = std::max(moved, std::sqrt(dx * dx + dy * dy));
 			}
+			diverse = flips >= min_binary_difference && moved >= min_position_distance;
 		}
-		if (g[*ei].type == Above || g[*ei].type == Under || g[*ei].type == CloseBy) {
-			obj4 += hyperparameters[3] * (x_i[g[source].id] - x_i[g[target].id] - offset[0]) * (x_i[g[source].id] - x_i[g[target].id] - offset[0]) / boundary.size[0] / boundary.size[0];
-			obj4 += hyperparameters[3] * (y_i[g[source].id] - y_i[g[target].id] - offset[1]) * (y_i[g[source].id] - y_i[g[target].id] - offset[1]) / boundary.size[1] / boundary.size[1];
-			num4++;
+		if (diverse) {
+			layouts.push_back(layout);
+			accepted_x.push_back(x);
 		}
 	}
-	if (num2 > 0)
-		obj2 /= num2;
-	if (num3 > 0)
-		obj3 /= num3;
-	if (num4 > 0)
-		obj4 /= num4;
-	model.setObjective(obj1 + obj2 + obj3 + obj4, GRB_MINIMIZE);
+	delete[] vars;
+	std::cout << "Collected " << layouts.size() << " distinct layouts from " << solCount << " pool solutions" << std::endl;
 }
 
 void Solver::optimizeModel()
 {
     try {
-        model.set(GRB_DoubleParam_TimeLimit, 10);
-		model.set(GRB_DoubleParam_MIPGap, 0.01);
-		model.set(GRB_IntParam_MIPFocus, 1);
-        model.set(GRB_IntParam_Method, 2);
-        model.set(GRB_DoubleParam_BarConvTol, 1e-4);
-        model.set(GRB_IntParam_Cuts, 2);
-        model.set(GRB_IntParam_Presolve, 0);
-        model.optimize();
-        while (model.get(GRB_IntAttr_Status) == GRB_INFEASIBLE) {
-			std::cout << "Model is infeasible. Calling IIS computation..." << std::endl;
-            handleInfeasibleModel();
-        }
-
-		if (graphProcessor.conflict_info.empty()) {
-			GRBVar* vars = model.getVars();
-        	int numVars = model.get(GRB_IntAttr_NumVars);
-        	for (auto i = 0; i < numVars; ++i) {
-        	    std::string varName = vars[i].get(GRB_StringAttr_VarName);
-        	    double varValue = vars[i].get(GRB_DoubleAttr_X);
-        	    std::cout << "Variable " << varName << ": Value = " << varValue << std::endl;
-        	}
-        	VertexIterator vi1, vi_end1;
-			for (boost::tie(vi1, vi_end1) = boost::vertices(g); vi1 != vi_end1; ++vi1) {
-        	    g[*vi1].pos = { 0, 0, 0 };
-        	    g[*vi1].size = { 0, 0, 0 };
-				std::string varName = "x_" + std::to_string(g[*vi1].id);
-				double varValue = model.getVarByName(varName).get(GRB_DoubleAttr_X);
-				g[*vi1].pos[0] = varValue;
-
-				varName = "y_" + std::to_string(g[*vi1].id);
-				varValue = model.getVarByName(varName).get(GRB_DoubleAttr_X);
-				g[*vi1].pos[1] = varValue;
-
-				varName = "l_" + std::to_string(g[*vi1].id);
-				varValue = model.getVarByName(varName).get(GRB_DoubleAttr_X);
-				g[*vi1].size[0] = varValue;
-
-				varName = "w_" + std::to_string(g[*vi1].id);
-				varValue = model.getVarByName(varName).get(GRB_DoubleAttr_X);
-				g[*vi1].size[1] = varValue;
-
-        	    varName = "z_" + std::to_string(g[*vi1].id);
-        	    varValue = model.getVarByName(varName).get(GRB_DoubleAttr_X);
-        	    g[*vi1].pos[2] = varValue;
-        	    varName = "h_" + std::to_string(g[*vi1].id);
-        	    varValue = model.getVarByName(varName).get(GRB_DoubleAttr_X);
-        	    g[*vi1].size[2] = varValue;
-        	}
-        	std::cout << "Value of objective function: " << model.get(GRB_DoubleAttr_ObjVal) << std::endl;
+		if (vertical_decoupled) {
+			verticalModel->set(GRB_DoubleParam_TimeLimit, solve_params.time_limit);
+			verticalModel->optimize();
+			if (verticalModel->get(GRB_IntAttr_Status) == GRB_INFEASIBLE) {
+				std::cout << "Vertical model is infeasible. Calling IIS computation..." << std::endl;
+				handleInfeasibleModel(*verticalModel);
+				return;
+			}
 		}
+		bool has_solution = false;
+		// The solution pool belongs to a single run, so alternative layouts use the single-model path
+		if (portfolio.size() > 1 && num_layouts <= 1) {
+			has_solution = optimizePortfolio();
+		}
+		else {
+			applyParams(*model, solve_params);
+			if (num_layouts > 1) {
+				// Over-sample the pool so enough candidates remain after the diversity filter
+				model->set(GRB_IntParam_PoolSolutions, num_layouts * 4);
+				model->set(GRB_IntParam_PoolSearchMode, 2);
+			}
+			model->optimize();
+			while (model->get(GRB_IntAttr_Status) == GRB_INFEASIBLE) {
+				std::cout << "Model is infeasible. Calling IIS computation..." << std::endl;
+				handleInfeasibleModel(*model);
+			}
+			recordProgress();
+			if (graphProcessor.conflict_info.empty()) {
+				readModelSolution();
+				has_solution = true;
+			}
+		}
+
+		if (has_solution && graphProcessor.conflict_info.empty())
+			applySolution();
     }
     catch (GRBException e) {
         std::cout << "Error code = " << e.getErrorCode() << std::endl;
@@ -471,77 +392,232 @@ void Solver::optimizeModel()
     }
 }
 
-void Solver::saveGraph()
+void Solver::readModelSolution()
 {
-    std::ofstream file_in("graph_in.dot");
-    if (!file_in.is_open()) {
-        std::cerr << "Failed to open file for writing: graph_in.dot" << std::endl;
-    } else {
-        boost::write_graphviz(file_in, inputGraph, vertex_writer_in<SceneGraph::vertex_descriptor>(inputGraph), 
-            edge_writer<SceneGraph::edge_descriptor>(inputGraph));
-    }
-    
-    std::ofstream file_out("graph_out.dot");
-    if (!file_out.is_open()) {
-        std::cerr << "Failed to open file for writing: graph_out.dot" << std::endl;
-    } else {
-        boost::write_graphviz(file_out, g, vertex_writer_out<SceneGraph::vertex_descriptor>(g),
-            edge_writer<SceneGraph::edge_descriptor>(g));
-    }
-	model.write("model.lp");
-
-	try
-    {
-        std::ifstream ifs(inputpath);
-        if (!ifs.is_open())
-            std::cerr << "Failed to open input JSON file: " << inputpath << std::endl;
-        
-        nlohmann::json j;
-        ifs >> j;
-        ifs.close();
-
-		if (!graphProcessor.conflict_info.empty()) {
-			j["conflict_info"] = graphProcessor.conflict_info;
-			j["plan_info"] = {};
-			for (auto i = 0; i < graphProcessor.plan_info.size(); ++i)
-				j["plan_info"].push_back(graphProcessor.plan_info[i]);
+	GRBVar* vars = model->getVars();
+	int numVars = model->get(GRB_IntAttr_NumVars);
+	double* x = model->get(GRB_DoubleAttr_X, vars, numVars);
+	solution.assign(x, x + numVars);
+	objective_value = model->get(GRB_DoubleAttr_ObjVal);
+	delete[] x;
+	delete[] vars;
+	if (num_layouts > 1) {
+		layouts.clear();
+		collectLayouts();
+	}
+}
+
+void Solver::applySolution()
+{
+	GRBVar* vars = model->getVars();
+	int numVars = model->get(GRB_IntAttr_NumVars);
+	for (auto i = 0; i < numVars; ++i) {
+	    std::string varName = vars[i].get(GRB_StringAttr_VarName);
+	    double varValue = solution[i];
+	    std::cout << "Variable " << varName << ": Value = " << varValue << std::endl;
+	}
+	delete[] vars;
+	auto value = [this](const std::string& varName) {
+		return solution[model->getVarByName(varName).index()];
+	};
+	auto zvalue = [this, &value](const std::string& varName) {
+		return vertical_decoupled ? verticalModel->getVarByName(varName).get(GRB_DoubleAttr_X) : value(varName);
+	};
+	VertexIterator vi1, vi_end1;
+	for (boost::tie(vi1, vi_end1) = boost::vertices(g); vi1 != vi_end1; ++vi1) {
+	    g[*vi1].pos = { 0, 0, 0 };
+	    g[*vi1].size = { 0, 0, 0 };
+		std::string id = std::to_string(g[*vi1].id);
+		g[*vi1].pos[0] = value("x_" + id);
+		g[*vi1].pos[1] = value("y_" + id);
+		g[*vi1].size[0] = value("l_" + id);
+		g[*vi1].size[1] = value("w_" + id);
+		g[*vi1].pos[2] = zvalue("z_" + id);
+		g[*vi1].size[2] = zvalue("h_" + id);
+	}
+	double objVal = objective_value;
+	if (vertical_decoupled)
+		objVal += verticalModel->get(GRB_DoubleAttr_ObjVal);
+	std::cout << "Value of objective function: " << objVal << std::endl;
+}
+
+void Solver::recordProgress()
+{
+	progress.time_limited = model->get(GRB_IntAttr_Status) == GRB_TIME_LIMIT;
+	if (model->get(GRB_IntAttr_SolCount) == 0)
+		progress.gap = std::numeric_limits<double>::infinity();
+	else
+		progress.gap = model->get(GRB_IntAttr_IsMIP) ? model->get(GRB_DoubleAttr_MIPGap) : 0;
+}
+
+bool Solver::resume(double seconds)
+{
+	// Gurobi continues the search tree of the last run when only the time limit changed
+	if (!progress.time_limited)
+		return false;
+	writer.wait();
+	try {
+		model->set(GRB_DoubleParam_TimeLimit, seconds);
+		model->optimize();
+		recordProgress();
+		if (model->get(GRB_IntAttr_SolCount) > 0) {
+			readModelSolution();
+			applySolution();
+			has_layout = true;
+			verifyLayout();
 		}
-		else {
-			j["conflict_info"] = "";
-			j["plan_info"] = {};
-			for (auto i = 0; i < j["vertices"].size(); ++i) {
-				j["vertices"][i]["position"] = {
-					g[boost::vertex(i, g)].pos[0],
-					g[boost::vertex(i, g)].pos[1],
-					g[boost::vertex(i, g)].pos[2]
-				};
-				j["vertices"][i]["size"] = {
-					g[boost::vertex(i, g)].size[0],
-					g[boost::vertex(i, g)].size[1],
-					g[boost::vertex(i, g)].size[2]
-				};
+	}
+	catch (GRBException e) {
+		std::cout << "Error code = " << e.getErrorCode() << std::endl;
+		std::cout << e.getMessage() << std::endl;
+		progress.time_limited = false;
+		return false;
+	}
+	return true;
+}
+
+ModelFeatures Solver::estimateFeatures()
+{
+	// The formulation is recorded instead of handed to Gurobi, so the counts are exact and no model is built
+	ModelFeatures estimate;
+	if (!graphProcessor.conflict_info.empty() || boost::num_vertices(g) == 0)
+		return estimate;
+	RecordingBackend recorder;
+	layoutModel.analyze(build_threads);
+	layoutModel.build(recorder, recorder, graphProcessor, params.break_symmetry);
+	estimate = layoutModel.features;
+	estimate.binaries = recorder.numBinaries();
+	estimate.constraints = recorder.numRows();
+	estimate.equality_constraints = recorder.numEqualities();
+	estimate.equality_ratio = estimate.constraints > 0 ? static_cast<double>(estimate.equality_constraints) / estimate.constraints : 0;
+	return estimate;
+}
+
+nlohmann::json Solver::result() const
+{
+	nlohmann::json j = inputJson();
+	fillResult(j);
+	return j;
+}
+
+nlohmann::json Solver::inputJson() const
+{
+	// Results go into the input document, so keys the reader does not know are written back unchanged.
+	// Only scenes given as native structs or binary files are serialized from the graph.
+	if (!scene_json.is_null())
+		return scene_json;
+	if (!scene_text.empty())
+		return nlohmann::json::parse(scene_text);
+	return sceneToJson();
+}
+
+void Solver::fillResult(nlohmann::json& j) const
+{
+	// j may be a DOM filled by an earlier solve
+	j.erase("layouts");
+	if (!graphProcessor.conflict_info.empty()) {
+		j["conflict_info"] = graphProcessor.conflict_info;
+		j["plan_info"] = nlohmann::json::array();
+		for (std::size_t i = 0; i < graphProcessor.plan_info.size(); ++i)
+			j["plan_info"].push_back(graphProcessor.plan_info[i]);
+	}
+	else {
+		j["conflict_info"] = "";
+		j["plan_info"] = nlohmann::json::array();
+		for (std::size_t i = 0; i < j["vertices"].size() && i < boost::num_vertices(g); ++i) {
+			const VertexProperties& vp = g[boost::vertex(i, g)];
+			if (vp.pos.size() < 3 || vp.size.size() < 3)
+				continue;
+			j["vertices"][i]["position"] = { vp.pos[0], vp.pos[1], vp.pos[2] };
+			j["vertices"][i]["size"] = { vp.size[0], vp.size[1], vp.size[2] };
+		}
+		if (verify_layout)
+			j["violations"] = LayoutVerifier::toJson(violations);
+		if (!layouts.empty()) {
+			j["layouts"] = nlohmann::json::array();
+			for (const auto& layout : layouts) {
+				nlohmann::json l;
+				l["objective"] = layout.objective;
+				l["vertices"] = nlohmann::json::array();
+				for (size_t v = 0; v < layout.pos.size(); ++v)
+					l["vertices"].push_back({ {"id", v}, {"position", layout.pos[v]}, {"size", layout.size[v]} });
+				j["layouts"].push_back(l);
 			}
 		}
+	}
+}
 
-		std::string outputpath = "output.json";
-        std::ofstream ofs(outputpath);
-        if (!ofs.is_open())
-        {
-            std::cerr << "Failed to open output JSON file: " << outputpath << std::endl;
-            return;
-        }
-        ofs << j.dump(4) << std::endl;
-        ofs.close();
-        std::cout << "JSON file has been updated and saved to: " << outputpath << std::endl;
-    }
-    catch (const std::exception& e)
-    {
-        std::cerr << "Exception occurred: " << e.what() << std::endl;
-    }
+void Solver::flushArtifacts()
+{
+	writer.wait();
+}
+
+void Solver::saveGraph()
+{
+	// Jobs read the members directly instead of copies; every mutator calls flushArtifacts first
+	writer.wait();
+	if (artifacts.graph_in) {
+		writer.submit([this] {
+			std::ofstream file_in("graph_in.dot");
+			if (!file_in.is_open()) {
+				std::cerr << "Failed to open file for writing: graph_in.dot" << std::endl;
+				return;
+			}
+			boost::write_graphviz(file_in, inputGraph, vertex_writer_in<SceneGraph::vertex_descriptor>(inputGraph),
+				edge_writer<SceneGraph::edge_descriptor>(inputGraph));
+		});
+	}
+	if (artifacts.graph_out) {
+		writer.submit([this] {
+			std::ofstream file_out("graph_out.dot");
+			if (!file_out.is_open()) {
+				std::cerr << "Failed to open file for writing: graph_out.dot" << std::endl;
+				return;
+			}
+			boost::write_graphviz(file_out, g, vertex_writer_out<SceneGraph::vertex_descriptor>(g),
+				edge_writer<SceneGraph::edge_descriptor>(g));
+		});
+	}
+	if (artifacts.model_lp) {
+		writer.submit([this] {
+			try {
+				model->write("model.lp");
+				if (vertical_decoupled)
+					verticalModel->write("model_vertical.lp");
+			}
+			catch (GRBException e) {
+				std::cerr << "Error code = " << e.getErrorCode() << std::endl;
+				std::cerr << e.getMessage() << std::endl;
+			}
+		});
+	}
+	if (artifacts.output_json) {
+		// The result is filled into the scene DOM in place, so output.json needs no second tree
+		if (scene_json.is_null()) {
+			scene_json = inputJson();
+			scene_text.clear();
+		}
+		fillResult(scene_json);
+		std::string outputpath = artifacts.output_path;
+		writer.submit([this, outputpath] {
+			std::ofstream ofs(outputpath);
+			if (!ofs.is_open()) {
+				std::cerr << "Failed to open output JSON file: " << outputpath << std::endl;
+				return;
+			}
+			ofs << scene_json.dump(4) << std::endl;
+			std::cout << "JSON file has been updated and saved to: " << outputpath << std::endl;
+		});
+	}
 }
 
 void Solver::solve()
 {
+	writer.wait();
+	progress = SolveProgress();
+	// params stay as the caller set them; profile and budget only shape this solve
+	solve_params = params;
+	applyBudget(solve_params);
 	if (inputGraph.m_vertices.empty()) {
 		std::cerr << "Scene Graph is empty!" << std::endl;
 	}
@@ -549,64 +625,203 @@ void Solver::solve()
 		std::cout << graphProcessor.conflict_info << std::endl;
 		std::cerr << "Conflict Constraints Found" << std::endl;
 	}
+	else if (multilevel.threshold > 0 && static_cast<int>(boost::num_vertices(g)) > multilevel.threshold && solveMultilevel()) {
+		verifyLayout();
+	}
 	else {
 		clearModel();
+		// A multilevel attempt or an earlier solve may have left its layouts behind
+		solution.clear();
+		layouts.clear();
+		violations.clear();
+		has_layout = false;
 		addConstraints();
+		if (!profiles.empty() || !features_log.empty())
+			extractFeatures();
+		if (!profiles.empty()) {
+			const SolverProfile* profile = profiles.select(features);
+			if (profile) {
+				solve_params = profiles.paramsFor(*profile, features, params);
+				applyBudget(solve_params);
+				std::cout << "Selected solver profile " << solve_params.name << " (time limit " << solve_params.time_limit << " s)" << std::endl;
+			}
+		}
+		auto start = std::chrono::steady_clock::now();
     	optimizeModel();
+		if (!features_log.empty())
+			logFeatures(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		has_layout = !solution.empty() && graphProcessor.conflict_info.empty();
+		verifyLayout();
 	}
-	saveGraph();
+}
+
+void Solver::applyBudget(SolverParams& p, int runs) const
+{
+	// Runs in parallel split the budget's threads; each may use the whole time
+	if (budget.seconds >= 0)
+		p.time_limit = budget.seconds;
+	if (budget.threads > 0)
+		p.threads = std::max(1, budget.threads / runs);
+}
+
+void Solver::verifyLayout()
+{
+	if (!verify_layout || !has_layout)
+		return;
+	violations = LayoutVerifier().verify(g, boundary);
+	if (violations.empty())
+		std::cout << "Layout verified" << std::endl;
+	else
+		std::cout << "Layout violates " << violations.size() << " constraint(s), worst " << violations[0].constraint
+			<< " by " << violations[0].magnitude << std::endl;
+}
+
+bool Solver::solveMultilevel()
+{
+	clearModel();
+	violations.clear();
+	layouts.clear();
+	has_layout = false;
+	// Children solve plain sub-scenes: no artifacts, no verification until the assembled layout
+	MultilevelSolver solver(multilevel, [this](Solver& child) {
+		child.hyperparameters = hyperparameters;
+		child.params = params;
+		child.portfolio = portfolio;
+		child.profiles = profiles;
+		child.multilevel = multilevel;
+		child.verify_layout = false;
+		// Clusters are already refined on multilevel.jobs threads
+		child.build_threads = multilevel.jobs > 1 ? 1 : build_threads;
+	});
+	if (!solver.solve(g, boundary)) {
+		std::cout << "Multilevel solve failed, solving the flat model" << std::endl;
+		return false;
+	}
+	// Relations cut between clusters are not enforced by any level, so the assembled layout is always checked,
+	// whether or not verify_layout is set
+	std::vector<Violation> cut = LayoutVerifier().verify(g, boundary);
+	if (!cut.empty()) {
+		std::cout << "Multilevel layout violates " << cut.size() << " constraint(s), worst " << cut[0].constraint
+			<< ", solving the flat model" << std::endl;
+		for (auto v : boost::make_iterator_range(boost::vertices(g))) {
+			g[v].pos.clear();
+			g[v].size.clear();
+		}
+		return false;
+	}
+	has_layout = true;
+	return true;
+}
+
+bool Solver::hasLayout() const
+{
+	return has_layout;
+}
+
+const SceneGraph& Solver::solvedGraph() const
+{
+	return g;
+}
+
+void Solver::sweep(const std::vector<std::vector<double>>& weights, const std::string& outputpath)
+{
+	writer.wait();
+	nlohmann::json results;
+	results["conflict_info"] = "";
+	results["plan_info"] = nlohmann::json::array();
+	results["runs"] = nlohmann::json::array();
+	// An empty scene still gets its (empty) result file
+	if (inputGraph.m_vertices.empty())
+		std::cerr << "Scene Graph is empty!" << std::endl;
+	else if (graphProcessor.conflict_info.empty()) {
+		// Constraints are built once; every weight vector only swaps the objective and warm-starts
+		// from the previous solution
+		solve_params = params;
+		clearModel();
+		addConstraints();
+		for (size_t k = 0; k < weights.size(); ++k) {
+			applyObjectiveWeights(weights[k]);
+			if (!solution.empty()) {
+				model->update();
+				GRBVar* vars = model->getVars();
+				model->set(GRB_DoubleAttr_Start, vars, solution.data(), static_cast<int>(solution.size()));
+				delete[] vars;
+			}
+			solution.clear();
+			auto start = std::chrono::steady_clock::now();
+			optimizeModel();
+			double runtime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			// Feasibility does not depend on the weights, so a conflict ends the sweep
+			if (!graphProcessor.conflict_info.empty())
+				break;
+
+			nlohmann::json run;
+			run["weights"] = weights[k];
+			run["runtime"] = runtime;
+			run["objective"] = nullptr;
+			run["vertices"] = nlohmann::json::array();
+			if (!solution.empty()) {
+				run["objective"] = objective_value + (vertical_decoupled ? verticalModel->get(GRB_DoubleAttr_ObjVal) : 0.0);
+				VertexIterator vi, vi_end;
+				for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
+					run["vertices"].push_back({ {"id", g[*vi].id}, {"position", g[*vi].pos}, {"size", g[*vi].size} });
+				}
+			}
+			results["runs"].push_back(run);
+		}
+	}
+	if (!graphProcessor.conflict_info.empty()) {
+		std::cout << graphProcessor.conflict_info << std::endl;
+		results["conflict_info"] = graphProcessor.conflict_info;
+		for (const auto& plan : graphProcessor.plan_info)
+			results["plan_info"].push_back(plan);
+	}
+
+	std::ofstream ofs(outputpath);
+	if (!ofs.is_open()) {
+		std::cerr << "Failed to open output JSON file: " << outputpath << std::endl;
+		return;
+	}
+	ofs << results.dump(4) << std::endl;
+	std::cout << "Sweep of " << results["runs"].size() << " weight vectors saved to: " << outputpath << std::endl;
 }
 
 void Solver::readSceneGraph(const std::string& path)
 {
+	// Streams the file (JSON or binary scene) straight into the graph; the DOM is only parsed for the result
 	reset();
+	std::string error;
+	if (!readSceneFile(path, inputGraph, boundary, error, &scene_text)) {
+		std::cerr << "Failed to read scene " << path << ": " << error << std::endl;
+		reset();
+		return;
+	}
+	computeBoundaryGeometry(boundary);
 	inputpath = path;
-	// Read JSON file
-	std::ifstream file(path);
-    nlohmann::json scene_graph_json;
-    file >> scene_graph_json;
+	processScene();
+}
+
+bool Solver::loadSceneText(std::string_view text, std::string& error)
+{
+	reset();
+	if (!readSceneJson(text.data(), text.data() + text.size(), inputGraph, boundary, error)) {
+		reset();
+		return false;
+	}
+	computeBoundaryGeometry(boundary);
+	scene_text = text;
+	processScene();
+	return true;
+}
 
+void Solver::loadScene(nlohmann::json scene_graph_json)
+{
+	reset();
     // Parse JSON to set boundary
     boundary.origin_pos = scene_graph_json["boundary"]["origin_pos"].get<std::vector<double>>();
     boundary.size = scene_graph_json["boundary"]["size"].get<std::vector<double>>();
     boundary.points = scene_graph_json["boundary"]["points"].get<std::vector<std::vector<double>>>();
-	// calculate orientations
-    boundary.Orientations = std::vector<Orientation>(boundary.points.size(), FRONT);
-	
-	for (auto i = 0; i < boundary.points.size(); ++i) {
-        // Get the current edge
-        std::vector<double> p1 = boundary.points[i];
-        std::vector<double> p2 = boundary.points[(i + 1) % boundary.points.size()];
-
-        // Calculate direction vector
-        std::vector<double> direction = {p2[0] - p1[0], p2[1] - p1[1]};
-
-        // Determine normal vector (rotate direction by 90 degrees)
-        std::vector<double> normal = {direction[1], -direction[0]};
-
-        // Determine orientation
-        if (normal[0] > 0) {
-            boundary.Orientations[i] = RIGHT;
-        } else if (normal[0] < 0) {
-            boundary.Orientations[i] = LEFT;
-        } else if (normal[1] > 0) {
-            boundary.Orientations[i] = FRONT;
-        } else {
-            boundary.Orientations[i] = BACK;
-        }
-    }
-	for (int i = 0; i < boundary.Orientations.size(); ++i) {
-		Orientation o1 = boundary.Orientations[i];
-		Orientation o2 = boundary.Orientations[(i + 1) % boundary.Orientations.size()];
-		if (o1 == LEFT && o2 == BACK)
-			boundary.BLcorner.push_back((i + 1) % boundary.Orientations.size());
-		else if (o1 == BACK && o2 == RIGHT)
-			boundary.BRcorner.push_back((i + 1) % boundary.Orientations.size());
-		else if (o1 == RIGHT && o2 == FRONT)
-			boundary.TRcorner.push_back((i + 1) % boundary.Orientations.size());
-		else if (o1 == FRONT && o2 == LEFT)
-			boundary.TLcorner.push_back((i + 1) % boundary.Orientations.size());
-	}
+	computeBoundaryGeometry(boundary);
     // Parse JSON to set vertices
     for (const auto& vertex : scene_graph_json["vertices"]) {
         VertexProperties vp;
@@ -619,32 +834,11 @@ void Solver::readSceneGraph(const std::string& path)
         vp.target_pos = vertex["target_pos"].get<std::vector<double>>();
         vp.target_size = vertex["target_size"].get<std::vector<double>>();
 		vp.orientation = vertex["orientation"];
-		vp.size_tolerance = {};
-		vp.pos_tolerance = {};
-		if (!vp.target_size.empty()) {
+		if (!vp.target_size.empty())
 			vp.size_tolerance = vertex["size_tolerance"].get<std::vector<double>>();
-			if (vp.size_tolerance.empty()) {
-				vp.size_tolerance = {0, 0, 0};
-				vp.size_tolerance[0] = vp.target_size[0] * 0.1;
-				vp.size_tolerance[1] = vp.target_size[1] * 0.1;
-				if (vp.on_floor)
-					vp.size_tolerance[2] = 0;
-				else
-					vp.size_tolerance[2] = vp.target_size[2] * 0.1;
-			}
-		}
-		if (!vp.target_pos.empty()) {
+		if (!vp.target_pos.empty())
 			vp.pos_tolerance = vertex["pos_tolerance"].get<std::vector<double>>();
-			if (vp.pos_tolerance.empty() && !vp.target_size.empty()) {
-				vp.pos_tolerance = {0, 0, 0};
-				vp.pos_tolerance[0] = vp.target_size[0] * 0.1;
-				vp.pos_tolerance[1] = vp.target_size[1] * 0.1;
-				if (vp.on_floor)
-					vp.pos_tolerance[2] = 0;
-				else
-					vp.pos_tolerance[2] = vp.target_size[2] * 0.1;
-			}
-		}
+		applyVertexDefaults(vp);
         auto v = add_vertex(vp, inputGraph);
     }
 
@@ -676,8 +870,67 @@ void Solver::readSceneGraph(const std::string& path)
         auto target = vertex(edge["target"], inputGraph);
         add_edge(source, target, ep, inputGraph);
     }
+	scene_json = std::move(scene_graph_json);
+	processScene();
+}
+
+void Solver::loadScene(const SceneGraph& graph, const Boundary& sceneBoundary)
+{
+	reset();
+	inputGraph = graph;
+	boundary = sceneBoundary;
+	if (boundary.Orientations.empty())
+		computeBoundaryGeometry(boundary);
+	processScene();
+}
+
+static nlohmann::json vertexToJson(const VertexProperties& vp)
+{
+	// corner is -1 away from corners, which the enum would write as an unsigned value
+	return { {"id", vp.id}, {"label", vp.label}, {"boundary", vp.boundary}, {"on_floor", vp.on_floor},
+		{"hanging", vp.hanging}, {"corner", static_cast<int>(vp.corner)}, {"orientation", vp.orientation},
+		{"target_pos", vp.target_pos}, {"target_size", vp.target_size}, {"pos_tolerance", vp.pos_tolerance},
+		{"size_tolerance", vp.size_tolerance} };
+}
+
+static nlohmann::json edgeToJson(int source, int target, const EdgeProperties& ep)
+{
+	return { {"source", source}, {"target", target}, {"type", ep.type}, {"distance", ep.distance},
+		{"align_edge", ep.align_edge}, {"xyoffset", ep.xyoffset} };
+}
+
+nlohmann::json Solver::sceneToJson() const
+{
+	nlohmann::json j;
+	j["boundary"] = { {"origin_pos", boundary.origin_pos}, {"size", boundary.size}, {"points", boundary.points} };
+	j["vertices"] = nlohmann::json::array();
+	VertexIterator vi, vi_end;
+	for (boost::tie(vi, vi_end) = boost::vertices(inputGraph); vi != vi_end; ++vi)
+		j["vertices"].push_back(vertexToJson(inputGraph[*vi]));
+	j["edges"] = nlohmann::json::array();
+	EdgeIterator ei, ei_end;
+	for (boost::tie(ei, ei_end) = boost::edges(inputGraph); ei != ei_end; ++ei) {
+		j["edges"].push_back(edgeToJson(inputGraph[boost::source(*ei, inputGraph)].id,
+			inputGraph[boost::target(*ei, inputGraph)].id, inputGraph[*ei]));
+	}
+	return j;
+}
+
+nlohmann::json* Solver::sceneDocument()
+{
+	// Edits go into the input document, so the result still carries every key of the input
+	if (scene_json.is_null() && !scene_text.empty()) {
+		scene_json = nlohmann::json::parse(scene_text);
+		scene_text.clear();
+	}
+	return scene_json.is_null() ? nullptr : &scene_json;
+}
 
+void Solver::processScene()
+{
     g = graphProcessor.process(inputGraph, boundary);
+	std::cout << "Merged " << graphProcessor.merged_edges << " duplicate relations, " <<
+		graphProcessor.implied_edges << " orderings are implied by transitivity" << std::endl;
 
 	VertexIterator vi, vi_end;
     for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
@@ -695,8 +948,80 @@ void Solver::readSceneGraph(const std::string& path)
     }
 }
 
+void Solver::addVertex(const VertexProperties& vp)
+{
+	writer.wait();
+	add_vertex(vp, inputGraph);
+	graphProcessor.insertVertex(g, vp);
+	if (nlohmann::json* doc = sceneDocument())
+		(*doc)["vertices"].push_back(vertexToJson(vp));
+}
+
+bool Solver::validEdgeEnds(int source, int target) const
+{
+	// An out-of-range descriptor would grow the vecS graphs instead of failing
+	int n = static_cast<int>(boost::num_vertices(inputGraph));
+	if (source >= 0 && source < n && target >= 0 && target < n && boost::num_vertices(g) == boost::num_vertices(inputGraph))
+		return true;
+	std::cerr << "Edge " << source << " -> " << target << " refers to an object that does not exist" << std::endl;
+	return false;
+}
+
+bool Solver::addEdge(int source, int target, const EdgeProperties& ep)
+{
+	writer.wait();
+	if (!validEdgeEnds(source, target))
+		return false;
+	if (!graphProcessor.insertEdge(g, vertex(source, g), vertex(target, g), ep)) {
+		std::cout << graphProcessor.conflict_info;
+		for (const auto& plan : graphProcessor.plan_info)
+			std::cout << plan;
+		// The edge was never added, so later solves see the scene as it was
+		graphProcessor.clearRejection();
+		return false;
+	}
+	add_edge(vertex(source, inputGraph), vertex(target, inputGraph), ep, inputGraph);
+	if (nlohmann::json* doc = sceneDocument())
+		(*doc)["edges"].push_back(edgeToJson(inputGraph[vertex(source, inputGraph)].id, inputGraph[vertex(target, inputGraph)].id, ep));
+	return true;
+}
+
+bool Solver::removeEdge(int source, int target, EdgeType type)
+{
+	writer.wait();
+	if (!validEdgeEnds(source, target))
+		return false;
+	graphProcessor.eraseEdge(g, vertex(source, g), vertex(target, g), type);
+	boost::graph_traits<SceneGraph>::out_edge_iterator oe_i, oe_end;
+	for (boost::tie(oe_i, oe_end) = boost::out_edges(vertex(source, inputGraph), inputGraph); oe_i != oe_end; ++oe_i) {
+		if (boost::target(*oe_i, inputGraph) == vertex(target, inputGraph) && inputGraph[*oe_i].type == type) {
+			boost::remove_edge(*oe_i, inputGraph);
+			break;
+		}
+	}
+	if (nlohmann::json* doc = sceneDocument()) {
+		int source_id = inputGraph[vertex(source, inputGraph)].id, target_id = inputGraph[vertex(target, inputGraph)].id;
+		auto& edges = (*doc)["edges"];
+		for (auto it = edges.begin(); it != edges.end(); ++it) {
+			if (it->value("source", -1) == source_id && it->value("target", -1) == target_id && it->value("type", -1) == type) {
+				edges.erase(it);
+				break;
+			}
+		}
+	}
+	return true;
+}
+
 void Solver::reset()
 {
+	writer.wait();
+	inputpath.clear();
+	scene_json = nlohmann::json();
+	scene_text.clear();
+	layouts.clear();
+	solution.clear();
+	violations.clear();
+	has_layout = false;
 	inputGraph.clear();
 	g.clear();
 	boundary = Boundary();
@@ -706,30 +1031,26 @@ void Solver::reset()
 	
 
 void Solver::clearModel() {
-	auto vars = model.getVars();
-	for (auto i = 0; i < model.get(GRB_IntAttr_NumVars); ++i) {
-		model.remove(vars[i]);
-	}
-	auto constrs = model.getConstrs();
-	for (auto i = 0; i < model.get(GRB_IntAttr_NumConstrs); ++i) {
-		model.remove(constrs[i]);
-	}
-	auto qconstrs = model.getQConstrs();
-	for (auto i = 0; i < model.get(GRB_IntAttr_NumQConstrs); ++i) {
-		model.remove(qconstrs[i]);
-	}
-	model.update();
+	// The models are swapped for empty ones from the pool instead of being emptied; models that were never
+	// written to are recycled, the others are freed
+	pool.release(std::move(model), backend.numVars() == 0);
+	pool.release(std::move(verticalModel), verticalBackend.numVars() == 0);
+	model = pool.acquire();
+	verticalModel = pool.acquire();
+	backend.attach(*model);
+	verticalBackend.attach(*verticalModel);
+	vertical_decoupled = false;
 }
 
-void Solver::handleInfeasibleModel() {
-	model.computeIIS();
+void Solver::handleInfeasibleModel(GRBModel& grbModel) {
+	grbModel.computeIIS();
 	graphProcessor.conflict_info = "Infeasible constraints found in IIS. List of constraints: \n";
 	graphProcessor.plan_info = {};
     
-    GRBConstr* constrs = model.getConstrs();
-	GRBVar* vars = model.getVars();
-    int numConstrs = model.get(GRB_IntAttr_NumConstrs);
-	int numVars = model.get(GRB_IntAttr_NumVars);
+    GRBConstr* constrs = grbModel.getConstrs();
+	GRBVar* vars = grbModel.getVars();
+    int numConstrs = grbModel.get(GRB_IntAttr_NumConstrs);
+	int numVars = grbModel.get(GRB_IntAttr_NumVars);
     
     std::vector<GRBConstr> infeasibleConstraints;
     for (int i = 0; i < numConstrs; ++i) {
@@ -755,5 +1076,5 @@ void Solver::handleInfeasibleModel() {
 	for (int i = 0; i < infeasibleVarBounds.size(); ++i) {
         graphProcessor.plan_info.push_back("Variable bounds " + std::to_string(i) + ": " + infeasibleVarBounds[i] + "\n");
 	}
-	model.optimize();
+	grbModel.optimize();
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "SolverProfiles.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+bool SolverProfiles::load(const std::string& path)
+{
+	try {
+		std::ifstream file(path);
+		if (!file.is_open()) {
+			std::cerr << "Failed to open solver profile file: " << path << std::endl;
+			return false;
+		}
+		nlohmann::json j;
+		file >> j;
+		profiles.clear();
+		for (const auto& p : j["profiles"]) {
+			SolverProfile profile;
+			profile.name = p.value("name", "profile_" + std::to_string(profiles.size()));
+			profile.max_vertices = p.value("max_vertices", -1);
+			profile.max_overlap_pairs = p.value("max_overlap_pairs", -1);
+			profile.max_binaries = p.value("max_binaries", -1);
+			profile.max_nonconvex_terms = p.value("max_nonconvex_terms", -1);
+			profile.max_equality_ratio = p.value("max_equality_ratio", -1.0);
+			profile.time_limit_per_binary = p.value("time_limit_per_binary", 0.0);
+			profile.max_time_limit = p.value("max_time_limit", -1.0);
+			if (p.contains("params"))
+				profile.params = p["params"];
+			profiles.push_back(profile);
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Exception occurred while reading solver profiles: " << e.what() << std::endl;
+		return false;
+	}
+	std::cout << "Loaded " << profiles.size() << " solver profiles from " << path << std::endl;
+	return true;
+}
+
+bool SolverProfiles::empty() const
+{
+	return profiles.empty();
+}
+
+const SolverProfile* SolverProfiles::select(const ModelFeatures& features) const
+{
+	auto within = [](double value, double limit) { return limit < 0 || value <= limit; };
+	for (const auto& p : profiles) {
+		if (within(features.vertices, p.max_vertices) && within(features.overlap_pairs, p.max_overlap_pairs) &&
+			within(features.binaries, p.max_binaries) && within(features.nonconvex_terms, p.max_nonconvex_terms) &&
+			within(features.equality_ratio, p.max_equality_ratio))
+			return &p;
+	}
+	return nullptr;
+}
+
+SolverParams SolverProfiles::paramsFor(const SolverProfile& profile, const ModelFeatures& features, SolverParams base) const
+{
+	SolverParams params = paramsFromJson(profile.params, base);
+	params.name = profile.name;
+	params.time_limit += profile.time_limit_per_binary * features.binaries;
+	if (profile.max_time_limit >= 0)
+		params.time_limit = std::min(params.time_limit, profile.max_time_limit);
+	return params;
+}
+
+nlohmann::json SolverProfiles::toJson(const ModelFeatures& features)
+{
+	return {
+		{"vertices", features.vertices},
+		{"overlap_pairs", features.overlap_pairs},
+		{"closeby_binaries", features.closeby_binaries},
+		{"corner_binaries", features.corner_binaries},
+		{"binaries", features.binaries},
+		{"constraints", features.constraints},
+		{"equality_constraints", features.equality_constraints},
+		{"equality_ratio", features.equality_ratio},
+		{"nonconvex_terms", features.nonconvex_terms},
+		{"vertical_decoupled", features.vertical_decoupled}
+	};
+}
+
+SolverParams SolverProfiles::paramsFromJson(const nlohmann::json& j, SolverParams base)
+{
+	base.time_limit = j.value("time_limit", base.time_limit);
+	base.mip_gap = j.value("mip_gap", base.mip_gap);
+	base.mip_focus = j.value("mip_focus", base.mip_focus);
+	base.method = j.value("method", base.method);
+	base.bar_conv_tol = j.value("bar_conv_tol", base.bar_conv_tol);
+	base.cuts = j.value("cuts", base.cuts);
+	base.presolve = j.value("presolve", base.presolve);
+	base.seed = j.value("seed", base.seed);
+	base.threads = j.value("threads", base.threads);
+	return base;
+}
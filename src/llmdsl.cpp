@@ -0,0 +1,65 @@
+#include "llmdsl.h"
+#include "Solver.h"
+#include <cstring>
+#include <memory>
+
+struct llmdsl_solver {
+	std::unique_ptr<Solver> solver;
+	std::string last_error;
+};
+
+llmdsl_solver* llmdsl_create(void)
+{
+	try {
+		auto handle = std::make_unique<llmdsl_solver>();
+		handle->solver = std::make_unique<Solver>();
+		return handle.release();
+	}
+	catch (...) {
+		return nullptr;
+	}
+}
+
+void llmdsl_destroy(llmdsl_solver* solver)
+{
+	delete solver;
+}
+
+void llmdsl_set_weights(llmdsl_solver* solver, double area, double size, double position, double adjacency)
+{
+	if (solver)
+		solver->solver->hyperparameters = { area, size, position, adjacency };
+}
+
+char* llmdsl_solve_json(llmdsl_solver* solver, const char* scene_json)
+{
+	if (!solver || !scene_json)
+		return nullptr;
+	try {
+		solver->last_error.clear();
+		if (!solver->solver->loadSceneText(scene_json, solver->last_error))
+			return nullptr;
+		solver->solver->solve();
+		std::string out = solver->solver->result().dump();
+		char* str = new char[out.size() + 1];
+		std::memcpy(str, out.c_str(), out.size() + 1);
+		return str;
+	}
+	catch (GRBException e) {
+		solver->last_error = e.getMessage();
+	}
+	catch (const std::exception& e) {
+		solver->last_error = e.what();
+	}
+	return nullptr;
+}
+
+const char* llmdsl_last_error(const llmdsl_solver* solver)
+{
+	return solver ? solver->last_error.c_str() : "";
+}
+
+void llmdsl_free(char* str)
+{
+	delete[] str;
+}
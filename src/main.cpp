@@ -1,12 +1,82 @@
 #include "Solver.h"
 #include "GraphProcessor.h"
+#include "SceneStream.h"
+#include "BatchScheduler.h"
 #include <string>
 #include <iostream>
 #include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <chrono>
+#ifdef _WIN32
+#include <io.h>
+#define dup _dup
+#define dup2 _dup2
+#define fileno _fileno
+#define fdopen _fdopen
+#else
+#include <unistd.h>
+#endif
+
+// Reads one weight vector per line: four entries, each either a number or a comma-separated list of
+// numbers. Lists expand to the Cartesian product, so "0.5,1,2 1 1 0,1" yields a 3 x 2 grid.
+static std::vector<std::vector<double>> readWeights(const std::string& path) {
+    std::vector<std::vector<double>> weights;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream tokens(line);
+        std::vector<std::vector<double>> axes;
+        std::string token;
+        bool numeric = true;
+        while (numeric && tokens >> token) {
+            std::vector<double> values;
+            std::istringstream items(token);
+            std::string item;
+            while (numeric && std::getline(items, item, ',')) {
+                size_t used = 0;
+                try {
+                    values.push_back(std::stod(item, &used));
+                }
+                catch (const std::exception&) {}
+                numeric = used > 0 && used == item.size();
+            }
+            axes.push_back(values);
+        }
+        if (!numeric) {
+            std::cerr << "Skipping weight line with a non-numeric entry: " << line << std::endl;
+            continue;
+        }
+        if (axes.empty())
+            continue;
+        if (axes.size() != 4) {
+            std::cerr << "Skipping weight line with " << axes.size() << " entries: " << line << std::endl;
+            continue;
+        }
+        std::vector<std::vector<double>> grid = { {} };
+        for (const auto& axis : axes) {
+            std::vector<std::vector<double>> expanded;
+            for (const auto& prefix : grid) {
+                for (double value : axis) {
+                    expanded.push_back(prefix);
+                    expanded.back().push_back(value);
+                }
+            }
+            grid = expanded;
+        }
+        weights.insert(weights.end(), grid.begin(), grid.end());
+    }
+    return weights;
+}
 
 int main(int argc, char *argv[]) {
-    if (argc != 6) {
-        std::cerr << "Usage: " << argv[0] << " <json_file> <param1> <param2> <param3> <param4>" << std::endl;
+    if (argc < 6) {
+        std::cerr << "Usage: " << argv[0] << " <json_file|-> <param1> <param2> <param3> <param4> [--portfolio <members>] [--sweep <weights_file> [--sweep-output <json_file>]]" <<
+            " [--layouts <k> [--diversity-binaries <n>] [--diversity-distance <d>]]" <<
+            " [--profiles <json_file>] [--features-log <file>]" <<
+            " [--artifacts <none|output,graph_in,graph_out,lp>] [--jobs <n>] [--deadline <seconds>]" <<
+            " [--multilevel <threshold> [--cluster-size <n>]]" << std::endl;
         return 1;
     }
 
@@ -16,11 +86,146 @@ int main(int argc, char *argv[]) {
     double param3 = std::stod(argv[4]);
     double param4 = std::stod(argv[5]);
 
+    // "-" streams newline-delimited scenes from stdin. Result lines own stdout, so everything else printed to it,
+    // including solver logs, is moved to stderr before the first solver is created.
+    bool streaming = json_name == "-";
+    FILE* records = nullptr;
+    if (streaming) {
+        std::fflush(stdout);
+        records = fdopen(dup(fileno(stdout)), "w");
+        dup2(fileno(stderr), fileno(stdout));
+    }
+    int jobs = 1;
+    // Negative streams scenes as they arrive; otherwise the whole batch is read first and solved within this budget
+    double deadline = -1;
+
     Solver solver;
     solver.hyperparameters = {param1, param2, param3, param4};
+    std::string weights_file, sweep_output = "sweep.json";
+    bool sweep_options = false;
+    solver.artifacts.output_json = true;
 
+    for (int i = 6; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--portfolio" && i + 1 < argc) {
+            solver.portfolio = Solver::defaultPortfolio(std::stoi(argv[++i]));
+        }
+        else if (option == "--sweep" && i + 1 < argc) {
+            weights_file = argv[++i];
+            sweep_options = true;
+        }
+        else if (option == "--sweep-output" && i + 1 < argc) {
+            sweep_output = argv[++i];
+            sweep_options = true;
+        }
+        else if (option == "--layouts" && i + 1 < argc) {
+            solver.num_layouts = std::stoi(argv[++i]);
+        }
+        else if (option == "--diversity-binaries" && i + 1 < argc) {
+            solver.min_binary_difference = std::stoi(argv[++i]);
+        }
+        else if (option == "--diversity-distance" && i + 1 < argc) {
+            solver.min_position_distance = std::stod(argv[++i]);
+        }
+        else if (option == "--profiles" && i + 1 < argc) {
+            if (!solver.profiles.load(argv[++i]))
+                return 1;
+        }
+        else if (option == "--features-log" && i + 1 < argc) {
+            solver.features_log = argv[++i];
+        }
+        else if (option == "--jobs" && i + 1 < argc) {
+            jobs = std::stoi(argv[++i]);
+        }
+        else if (option == "--deadline" && i + 1 < argc) {
+            deadline = std::stod(argv[++i]);
+        }
+        else if (option == "--multilevel" && i + 1 < argc) {
+            solver.multilevel.threshold = std::stoi(argv[++i]);
+        }
+        else if (option == "--cluster-size" && i + 1 < argc) {
+            solver.multilevel.max_cluster_size = std::stoi(argv[++i]);
+        }
+        else if (option == "--artifacts" && i + 1 < argc) {
+            solver.artifacts = ArtifactOptions();
+            std::istringstream names(argv[++i]);
+            std::string name;
+            while (std::getline(names, name, ',')) {
+                if (name == "output") solver.artifacts.output_json = true;
+                else if (name == "graph_in") solver.artifacts.graph_in = true;
+                else if (name == "graph_out") solver.artifacts.graph_out = true;
+                else if (name == "lp") solver.artifacts.model_lp = true;
+                else if (name != "none") {
+                    std::cerr << "Unknown artifact: " << name << std::endl;
+                    return 1;
+                }
+            }
+        }
+        else {
+            std::cerr << "Unknown option: " << option << std::endl;
+            return 1;
+        }
+    }
+
+    if (streaming) {
+        if (sweep_options) {
+            std::cerr << "--sweep needs a scene file; it cannot be combined with streaming from stdin" << std::endl;
+            return 1;
+        }
+        auto configure = [&solver, jobs](Solver& worker) {
+            worker.hyperparameters = solver.hyperparameters;
+            worker.params = solver.params;
+            worker.portfolio = solver.portfolio;
+            worker.num_layouts = solver.num_layouts;
+            worker.min_binary_difference = solver.min_binary_difference;
+            worker.min_position_distance = solver.min_position_distance;
+            worker.profiles = solver.profiles;
+            worker.features_log = solver.features_log;
+            worker.multilevel = solver.multilevel;
+            worker.build_threads = jobs > 1 ? 1 : solver.build_threads;
+        };
+        if (deadline >= 0) {
+            std::vector<std::string> scenes;
+            std::string line;
+            while (std::getline(std::cin, line)) {
+                if (line.find_first_not_of(" \t\r") != std::string::npos)
+                    scenes.push_back(line);
+            }
+            BatchParams batch;
+            batch.budget = deadline;
+            batch.cores = jobs;
+            BatchScheduler scheduler(batch, configure);
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& record : scheduler.run(scenes)) {
+                std::string text = record.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+                std::fwrite(text.data(), 1, text.size(), records);
+                std::fputc('\n', records);
+            }
+            std::fclose(records);
+            std::cerr << "Solved " << scenes.size() << " scenes in " <<
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+            return 0;
+        }
+        SceneStream stream(jobs, configure);
+        size_t count = stream.run(std::cin, [records](const std::string& line) {
+            std::fwrite(line.data(), 1, line.size(), records);
+            std::fputc('\n', records);
+            std::fflush(records);
+        });
+        std::fclose(records);
+        std::cerr << "Streamed " << count << " scenes" << std::endl;
+        return 0;
+    }
+
+    // A single scene spends the jobs on refining clusters in parallel; a stream spends them on scenes
+    solver.multilevel.jobs = jobs;
     solver.readSceneGraph(json_name);
-    solver.solve();
+    if (!weights_file.empty())
+        solver.sweep(readWeights(weights_file), sweep_output);
+    else {
+        solver.solve();
+        solver.saveGraph();
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,276 @@
+/*Times scene loading, graph processing and model construction against the recording backend, so model-build
+performance can be measured without a solver license. Optionally writes the recorded model in LP format and replays
+a stored solution through the layout verifier. --self-check compares the graph algorithms with brute-force
+references on random graphs.*/
+#include "GraphProcessor.h"
+#include "IncrementalCycleDetector.h"
+#include "LayoutModel.h"
+#include "LayoutVerifier.h"
+#include "RecordingBackend.h"
+#include "SceneReader.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <numeric>
+#include <random>
+#include <string>
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool acyclic(int n, const std::vector<std::pair<int, int>>& arcs, const std::vector<bool>& kept) {
+    // Kahn's algorithm over the kept arcs
+    std::vector<int> indegree(n, 0);
+    std::vector<std::vector<int>> out(n);
+    for (size_t i = 0; i < arcs.size(); ++i) {
+        if (kept[i]) {
+            out[arcs[i].first].push_back(arcs[i].second);
+            indegree[arcs[i].second]++;
+        }
+    }
+    std::vector<int> ready;
+    for (int v = 0; v < n; ++v)
+        if (indegree[v] == 0) ready.push_back(v);
+    int sorted = 0;
+    while (!ready.empty()) {
+        int v = ready.back();
+        ready.pop_back();
+        ++sorted;
+        for (int w : out[v])
+            if (--indegree[w] == 0) ready.push_back(w);
+    }
+    return sorted == n;
+}
+
+// The feedback arc set of small graphs must be acyclic, minimal and of the weight of the best vertex order
+static int checkFeedbackArcSets(std::mt19937& rng, int rounds) {
+    int failures = 0;
+    GraphProcessor processor;
+    for (int r = 0; r < rounds; ++r) {
+        int n = std::uniform_int_distribution<int>(1, 8)(rng);
+        int m = std::uniform_int_distribution<int>(0, 3 * n)(rng);
+        std::vector<std::pair<int, int>> arcs;
+        std::vector<int> weights;
+        for (int i = 0; i < m; ++i) {
+            arcs.push_back({ std::uniform_int_distribution<int>(0, n - 1)(rng), std::uniform_int_distribution<int>(0, n - 1)(rng) });
+            weights.push_back(std::uniform_int_distribution<int>(1, 3)(rng));
+        }
+        std::vector<int> fas = processor.feedbackArcSet(n, arcs, weights);
+        std::vector<bool> kept(m, true);
+        int weight = 0;
+        for (int a : fas) {
+            kept[a] = false;
+            weight += weights[a];
+        }
+        bool ok = acyclic(n, arcs, kept);
+        for (int a : fas) {
+            kept[a] = true;
+            ok = ok && !acyclic(n, arcs, kept);
+            kept[a] = false;
+        }
+        std::vector<int> order(n), position(n);
+        std::iota(order.begin(), order.end(), 0);
+        int best = std::numeric_limits<int>::max();
+        do {
+            for (int k = 0; k < n; ++k) position[order[k]] = k;
+            int backward = 0;
+            for (int i = 0; i < m; ++i)
+                if (position[arcs[i].first] >= position[arcs[i].second]) backward += weights[i];
+            best = std::min(best, backward);
+        } while (std::next_permutation(order.begin(), order.end()));
+        if (!ok || weight != best) {
+            std::cerr << "feedback arc set: n=" << n << " arcs=" << m << " weight " << weight << ", optimum " << best
+                << (ok ? "" : ", not acyclic or not minimal") << std::endl;
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+// Random inserts and erases: the dynamic order must accept exactly the edges a full topological sort accepts, and
+// report a path of existing edges for the ones it rejects
+static int checkIncrementalOrders(std::mt19937& rng, int rounds) {
+    int failures = 0;
+    for (int r = 0; r < rounds; ++r) {
+        int n = std::uniform_int_distribution<int>(1, 12)(rng);
+        SceneGraph empty;
+        for (int v = 0; v < n; ++v)
+            boost::add_vertex(VertexProperties(), empty);
+        IncrementalCycleDetector detector;
+        detector.reset(empty);
+        std::vector<std::pair<int, int>> arcs;
+        std::vector<VertexDescriptor> cycle;
+        for (int step = 0; step < 4 * n; ++step) {
+            if (!arcs.empty() && std::uniform_int_distribution<int>(0, 3)(rng) == 0) {
+                size_t k = std::uniform_int_distribution<size_t>(0, arcs.size() - 1)(rng);
+                detector.removeEdge(arcs[k].first, arcs[k].second, LeftOf);
+                arcs.erase(arcs.begin() + k);
+                continue;
+            }
+            int s = std::uniform_int_distribution<int>(0, n - 1)(rng), t = std::uniform_int_distribution<int>(0, n - 1)(rng);
+            arcs.push_back({ s, t });
+            bool expected = acyclic(n, arcs, std::vector<bool>(arcs.size(), true));
+            bool accepted = detector.insertEdge(s, t, LeftOf, cycle);
+            bool ok = accepted == expected;
+            if (!accepted) {
+                arcs.pop_back();
+                ok = ok && !cycle.empty() && static_cast<int>(cycle.front()) == t && static_cast<int>(cycle.back()) == s;
+                for (size_t i = 0; ok && i + 1 < cycle.size(); ++i) {
+                    std::pair<int, int> arc(static_cast<int>(cycle[i]), static_cast<int>(cycle[i + 1]));
+                    ok = std::find(arcs.begin(), arcs.end(), arc) != arcs.end();
+                }
+            }
+            if (!ok) {
+                std::cerr << "incremental order: n=" << n << " step " << step << " edge " << s << " -> " << t
+                    << (accepted ? " accepted" : " rejected") << ", expected " << (expected ? "accepted" : "rejected") << std::endl;
+                ++failures;
+                break;
+            }
+        }
+    }
+    return failures;
+}
+
+static int selfCheck(int rounds) {
+    std::mt19937 rng(12345);
+    int failures = checkFeedbackArcSets(rng, rounds) + checkIncrementalOrders(rng, rounds);
+    std::cout << (failures ? "FAILED: " : "ok: ") << failures << " failures in " << rounds << " rounds" << std::endl;
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <scene> [--threads <n>] [--iterations <n>] [--no-symmetry]"
+            " [--lp <file>] [--solution <file.sol>]" << std::endl
+            << "       " << argv[0] << " --self-check [rounds]" << std::endl;
+        return 2;
+    }
+    if (std::string(argv[1]) == "--self-check")
+        return selfCheck(argc > 2 ? std::stoi(argv[2]) : 1000);
+    std::string scene = argv[1], lp_path, solution_path;
+    int threads = 0, iterations = 1;
+    bool break_symmetry = true;
+    for (int i = 2; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--threads" && i + 1 < argc)
+            threads = std::stoi(argv[++i]);
+        else if (option == "--iterations" && i + 1 < argc)
+            iterations = std::stoi(argv[++i]);
+        else if (option == "--no-symmetry")
+            break_symmetry = false;
+        else if (option == "--lp" && i + 1 < argc)
+            lp_path = argv[++i];
+        else if (option == "--solution" && i + 1 < argc)
+            solution_path = argv[++i];
+        else {
+            std::cerr << "Unknown option: " << option << std::endl;
+            return 2;
+        }
+    }
+
+    // Best of iterations for every phase; the model of the last iteration is kept
+    double load = 1e300, process = 1e300, analyze = 1e300, build = 1e300;
+    SceneGraph input, g;
+    Boundary boundary;
+    GraphProcessor processor;
+    RecordingBackend model, vertical;
+    bool decoupled = false;
+    std::unique_ptr<LayoutModel> layout;
+    for (int k = 0; k < iterations; ++k) {
+        input = SceneGraph();
+        boundary = Boundary();
+        std::string error;
+        auto start = std::chrono::steady_clock::now();
+        if (!readSceneFile(scene, input, boundary, error)) {
+            std::cerr << error << std::endl;
+            return 2;
+        }
+        computeBoundaryGeometry(boundary);
+        load = std::min(load, since(start));
+
+        start = std::chrono::steady_clock::now();
+        processor = GraphProcessor();
+        g = processor.process(input, boundary);
+        process = std::min(process, since(start));
+        if (!processor.conflict_info.empty()) {
+            std::cerr << processor.conflict_info << std::endl;
+            return 1;
+        }
+
+        start = std::chrono::steady_clock::now();
+        layout = std::make_unique<LayoutModel>(g, boundary);
+        layout->analyze(threads);
+        analyze = std::min(analyze, since(start));
+
+        start = std::chrono::steady_clock::now();
+        model = RecordingBackend();
+        vertical = RecordingBackend();
+        decoupled = layout->vertical_decoupled;
+        layout->build(model, decoupled ? vertical : model, processor, break_symmetry);
+        ObjectiveAssembler objective;
+        for (size_t t = 0; t < layout->objective_terms.size(); ++t) {
+            objective.add(layout->objective_terms[t], 1);
+            if (!decoupled)
+                objective.add(layout->vertical_objective_terms[t], 1);
+        }
+        model.setObjective(objective);
+        if (decoupled) {
+            ObjectiveAssembler vertical_objective;
+            for (const auto& term : layout->vertical_objective_terms)
+                vertical_objective.add(term, 1);
+            vertical.setObjective(vertical_objective);
+        }
+        build = std::min(build, since(start));
+    }
+
+    nlohmann::json record;
+    record["scene"] = scene;
+    record["objects"] = boost::num_vertices(g);
+    record["relations"] = boost::num_edges(g);
+    record["overlap_pairs"] = layout->overlap_pairs.size();
+    record["vertical_decoupled"] = decoupled;
+    record["variables"] = model.numVars() + vertical.numVars();
+    record["binaries"] = model.numBinaries();
+    record["rows"] = model.numRows() + vertical.numRows();
+    record["nonzeros"] = model.numNonzeros() + vertical.numNonzeros();
+    record["objective_terms"] = model.numObjectiveTerms() + vertical.numObjectiveTerms();
+    record["seconds"] = { {"load", load}, {"process", process}, {"analyze", analyze}, {"build", build} };
+
+    if (!lp_path.empty()) {
+        std::ofstream out(lp_path);
+        model.writeLP(out);
+        if (decoupled) {
+            std::ofstream vertical_out(lp_path + ".vertical.lp");
+            vertical.writeLP(vertical_out);
+        }
+    }
+    if (!solution_path.empty()) {
+        // The stored solution holds every variable of both models when they were solved together
+        std::string error;
+        if (!model.loadSolution(solution_path, error) || (decoupled && !vertical.loadSolution(solution_path, error))) {
+            std::cerr << error << std::endl;
+            return 2;
+        }
+        bool replayed = model.optimize() && (!decoupled || vertical.optimize());
+        record["replayed"] = replayed;
+        if (replayed) {
+            record["objective"] = model.objectiveValue() + (decoupled ? vertical.objectiveValue() : 0.0);
+            RecordingBackend& zmodel = decoupled ? vertical : model;
+            VertexIterator vi, vi_end;
+            for (boost::tie(vi, vi_end) = boost::vertices(g); vi != vi_end; ++vi) {
+                int i = g[*vi].id;
+                g[*vi].pos = { model.value(layout->x[i]), model.value(layout->y[i]), zmodel.value(layout->z[i]) };
+                g[*vi].size = { model.value(layout->l[i]), model.value(layout->w[i]), zmodel.value(layout->h[i]) };
+            }
+            LayoutVerifier verifier;
+            record["violations"] = LayoutVerifier::toJson(verifier.verify(g, boundary));
+        }
+    }
+    std::cout << record.dump() << std::endl;
+    return 0;
+}
@@ -0,0 +1,209 @@
+/*Converts JSON scenes to the binary scene format, and measures parse throughput of the DOM, SAX and binary paths.
+--check round-trips a scene through both formats and makes sure a scene missing any required key is rejected.*/
+#include "SceneReader.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+static bool readText(const std::string& path, std::string& text) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    text = buffer.str();
+    return true;
+}
+
+static nlohmann::json sceneJson(const SceneGraph& graph, const Boundary& boundary) {
+    nlohmann::json j;
+    j["boundary"] = { {"origin_pos", boundary.origin_pos}, {"size", boundary.size}, {"points", boundary.points} };
+    j["vertices"] = nlohmann::json::array();
+    for (auto v : boost::make_iterator_range(boost::vertices(graph))) {
+        const VertexProperties& vp = graph[v];
+        // corner is -1 away from corners, which the enum would write as an unsigned value
+        j["vertices"].push_back({ {"id", vp.id}, {"label", vp.label}, {"boundary", vp.boundary}, {"on_floor", vp.on_floor},
+            {"hanging", vp.hanging}, {"corner", static_cast<int>(vp.corner)}, {"orientation", vp.orientation},
+            {"target_pos", vp.target_pos}, {"target_size", vp.target_size}, {"pos_tolerance", vp.pos_tolerance},
+            {"size_tolerance", vp.size_tolerance} });
+    }
+    j["edges"] = nlohmann::json::array();
+    for (auto e : boost::make_iterator_range(boost::edges(graph))) {
+        const EdgeProperties& ep = graph[e];
+        j["edges"].push_back({ {"source", boost::source(e, graph)}, {"target", boost::target(e, graph)}, {"type", ep.type},
+            {"distance", ep.distance}, {"align_edge", ep.align_edge}, {"xyoffset", ep.xyoffset} });
+    }
+    return j;
+}
+
+// Empty when both scenes hold the same boundary, vertices and edges, in the same order
+static std::string sceneDifference(const SceneGraph& a, const Boundary& ba, const SceneGraph& b, const Boundary& bb) {
+    if (ba.origin_pos != bb.origin_pos || ba.size != bb.size || ba.points != bb.points)
+        return "boundary differs";
+    if (boost::num_vertices(a) != boost::num_vertices(b) || boost::num_edges(a) != boost::num_edges(b))
+        return "vertex or edge count differs";
+    for (size_t i = 0; i < boost::num_vertices(a); ++i) {
+        const VertexProperties& x = a[boost::vertex(i, a)];
+        const VertexProperties& y = b[boost::vertex(i, b)];
+        if (std::tie(x.id, x.label, x.boundary, x.corner, x.orientation, x.on_floor, x.hanging, x.target_pos, x.target_size,
+                x.pos_tolerance, x.size_tolerance) != std::tie(y.id, y.label, y.boundary, y.corner, y.orientation, y.on_floor,
+                y.hanging, y.target_pos, y.target_size, y.pos_tolerance, y.size_tolerance))
+            return "vertex " + std::to_string(i) + " differs";
+    }
+    auto ea = boost::edges(a).first, eb = boost::edges(b).first;
+    for (size_t i = 0; i < boost::num_edges(a); ++i, ++ea, ++eb) {
+        const EdgeProperties& x = a[*ea];
+        const EdgeProperties& y = b[*eb];
+        if (boost::source(*ea, a) != boost::source(*eb, b) || boost::target(*ea, a) != boost::target(*eb, b) ||
+            std::tie(x.type, x.distance, x.align_edge, x.xyoffset) != std::tie(y.type, y.distance, y.align_edge, y.xyoffset))
+            return "edge " + std::to_string(i) + " differs";
+    }
+    return "";
+}
+
+static int check(const std::string& path) {
+    std::string text, error;
+    if (!readText(path, text)) {
+        std::cerr << "cannot open " << path << std::endl;
+        return 1;
+    }
+    SceneGraph graph, from_binary, from_json;
+    Boundary boundary, binary_boundary, json_boundary;
+    if (!readSceneJson(text.data(), text.data() + text.size(), graph, boundary, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    int failures = 0;
+    // JSON -> binary -> JSON must reproduce the scene as first read
+    std::string binary = (std::filesystem::temp_directory_path() / "scene_convert_check.ldsg").string();
+    if (!writeSceneBinary(binary, graph, boundary, error) || !readSceneBinary(binary, from_binary, binary_boundary, error)) {
+        std::cerr << "binary round trip: " << error << std::endl;
+        ++failures;
+    }
+    else {
+        std::string json = sceneJson(from_binary, binary_boundary).dump();
+        std::string difference = sceneDifference(graph, boundary, from_binary, binary_boundary);
+        if (difference.empty() && !readSceneJson(json.data(), json.data() + json.size(), from_json, json_boundary, error))
+            difference = error;
+        if (difference.empty())
+            difference = sceneDifference(graph, boundary, from_json, json_boundary);
+        if (!difference.empty()) {
+            std::cerr << "round trip: " << difference << std::endl;
+            ++failures;
+        }
+    }
+    std::filesystem::remove(binary);
+
+    // Every required key, removed on its own, must make the reader fail with a message naming it
+    nlohmann::json scene = nlohmann::json::parse(text);
+    std::vector<std::pair<nlohmann::json::json_pointer, std::string>> required = {
+        { nlohmann::json::json_pointer("/boundary"), "boundary" },
+        { nlohmann::json::json_pointer("/boundary/origin_pos"), "origin_pos" },
+        { nlohmann::json::json_pointer("/boundary/size"), "size" },
+        { nlohmann::json::json_pointer("/boundary/points"), "points" },
+    };
+    if (!scene["vertices"].empty()) {
+        for (const char* key : { "id", "label", "boundary", "corner", "orientation", "on_floor", "hanging", "target_pos", "target_size" })
+            required.push_back({ nlohmann::json::json_pointer(std::string("/vertices/0/") + key), key });
+    }
+    if (!scene["edges"].empty()) {
+        for (const char* key : { "source", "target", "type" })
+            required.push_back({ nlohmann::json::json_pointer(std::string("/edges/0/") + key), key });
+    }
+    for (const auto& [pointer, key] : required) {
+        nlohmann::json broken = scene;
+        broken[pointer.parent_pointer()].erase(pointer.back());
+        std::string json = broken.dump();
+        SceneGraph g;
+        Boundary b;
+        error.clear();
+        if (readSceneJson(json.data(), json.data() + json.size(), g, b, error) || error.find(key) == std::string::npos) {
+            std::cerr << "missing " << pointer.to_string() << ": " << (error.empty() ? "accepted" : error) << std::endl;
+            ++failures;
+        }
+    }
+    std::cout << path << ": " << (failures ? "FAILED, " : "ok, ") << required.size() << " missing-key cases, "
+        << failures << " failures" << std::endl;
+    return failures ? 1 : 0;
+}
+
+// Runs load() iterations times and reports scenes/s and MB/s relative to the JSON size
+template <class Load>
+static void bench(const char* name, int iterations, size_t bytes, Load load) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        load();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << seconds / iterations * 1e3 << " ms/scene, "
+        << iterations / seconds << " scenes/s, "
+        << bytes * static_cast<double>(iterations) / seconds / (1 << 20) << " MB/s" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3 || (std::string(argv[1]) == "--bench" && argc > 4)) {
+        std::cerr << "Usage: " << argv[0] << " <scene.json> <scene.ldsg>" << std::endl
+            << "       " << argv[0] << " --bench <scene.json> [iterations]" << std::endl
+            << "       " << argv[0] << " --check <scene.json>" << std::endl;
+        return 1;
+    }
+    if (std::string(argv[1]) == "--check")
+        return check(argv[2]);
+
+    if (std::string(argv[1]) != "--bench") {
+        SceneGraph graph;
+        Boundary boundary;
+        std::string error;
+        if (!readSceneFile(argv[1], graph, boundary, error) || !writeSceneBinary(argv[2], graph, boundary, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << boost::num_vertices(graph) << " vertices and " << boost::num_edges(graph)
+            << " edges to " << argv[2] << std::endl;
+        return 0;
+    }
+
+    std::string path = argv[2];
+    int iterations = argc > 3 ? std::stoi(argv[3]) : 100;
+    std::string text;
+    if (!readText(path, text)) {
+        std::cerr << "cannot open " << path << std::endl;
+        return 1;
+    }
+    SceneGraph graph;
+    Boundary boundary;
+    std::string error;
+    if (!readSceneJson(text.data(), text.data() + text.size(), graph, boundary, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::string binary = (std::filesystem::temp_directory_path() / "scene_convert_bench.ldsg").string();
+    if (!writeSceneBinary(binary, graph, boundary, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::cout << path << ": " << text.size() << " bytes JSON, " << std::filesystem::file_size(binary) << " bytes binary, "
+        << boost::num_vertices(graph) << " vertices, " << boost::num_edges(graph) << " edges" << std::endl;
+
+    // The DOM path only parses; building the graph from the DOM comes on top
+    bench("json dom parse", iterations, text.size(), [&] {
+        nlohmann::json j = nlohmann::json::parse(text);
+    });
+    bench("json sax to graph", iterations, text.size(), [&] {
+        SceneGraph g;
+        Boundary b;
+        readSceneJson(text.data(), text.data() + text.size(), g, b, error);
+    });
+    bench("binary mmap to graph", iterations, text.size(), [&] {
+        SceneGraph g;
+        Boundary b;
+        readSceneBinary(binary, g, b, error);
+    });
+    std::filesystem::remove(binary);
+    return 0;
+}
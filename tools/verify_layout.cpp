@@ -0,0 +1,42 @@
+/*Checks solved layouts in output.json files against their scene's hard constraints, independently of the solver.*/
+#include "LayoutVerifier.h"
+#include "SceneReader.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " [--tolerance <t>] <output.json>..." << std::endl;
+        return 2;
+    }
+    LayoutVerifier verifier;
+    bool failed = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--tolerance" && i + 1 < argc) {
+            verifier.tolerance = std::stod(argv[++i]);
+            continue;
+        }
+        SceneGraph graph;
+        Boundary boundary;
+        std::string error;
+        if (!readSceneFile(arg, graph, boundary, error)) {
+            std::cerr << error << std::endl;
+            return 2;
+        }
+        computeBoundaryGeometry(boundary);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Violation> violations = verifier.verify(graph, boundary);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // One JSON line per file
+        nlohmann::json record;
+        record["file"] = arg;
+        record["objects"] = boost::num_vertices(graph);
+        record["verify_seconds"] = seconds;
+        record["violations"] = LayoutVerifier::toJson(violations);
+        std::cout << record.dump() << std::endl;
+        failed = failed || !violations.empty();
+    }
+    return failed ? 1 : 0;
+}